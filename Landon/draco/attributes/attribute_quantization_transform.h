@@ -20,6 +20,7 @@
 #include "draco/attributes/attribute_transform.h"
 #include "draco/attributes/point_attribute.h"
 #include "draco/core/encoder_buffer.h"
+#include "draco/core/quantization_utils.h"
 
 namespace draco {
 
@@ -63,6 +64,35 @@ class AttributeQuantizationTransform : public AttributeTransform {
       const PointAttribute &attribute, const std::vector<PointIndex> &point_ids,
       int num_points) const;
 
+  // Dequantizes |num_entries| entries of |quantized_values| directly into the
+  // buffer of the float attribute |target|, starting at its first value.
+  // Returns false when |target| is not a tightly packed float attribute with
+  // the same number of components and at least |num_entries| values.
+  bool DequantizeValues(const int32_t *quantized_values, int num_entries,
+                        PointAttribute *target) const {
+    const int num_components = static_cast<int>(min_values_.size());
+    if (!is_initialized() || target->data_type() != DT_FLOAT32 ||
+        target->num_components() != num_components ||
+        target->byte_stride() !=
+            static_cast<int64_t>(sizeof(float) * num_components) ||
+        target->size() < static_cast<size_t>(num_entries)) {
+      return false;
+    }
+    if (num_entries == 0) {
+      return true;
+    }
+    const int32_t max_quantized_value = (1 << quantization_bits_) - 1;
+    Dequantizer dequantizer;
+    if (!dequantizer.Init(range_, max_quantized_value)) {
+      return false;
+    }
+    float *const out_values =
+        reinterpret_cast<float *>(target->GetAddress(AttributeValueIndex(0)));
+    dequantizer.DequantizeFloats(quantized_values, num_entries, num_components,
+                                 min_values_.data(), out_values);
+    return true;
+  }
+
  private:
   int32_t quantization_bits_;
 
@@ -47,6 +47,10 @@
 
 namespace draco {
 
+// Number of vectors converted together by the batch conversions of
+// OctahedronToolBox.
+static constexpr int kOctahedralBatchSize = 8;
+
 class OctahedronToolBox {
  public:
   OctahedronToolBox()
@@ -252,6 +256,65 @@ class OctahedronToolBox {
     OctaherdalCoordsToUnitVector(in_s * scale, in_t * scale, out_vector);
   }
 
+  // Batch version of IntegerVectorToQuantizedOctahedralCoords(). Converts
+  // |num_vectors| vectors from |int_vecs| (3 values per vector) to octahedral
+  // coordinates stored in |out_coords| (2 values per vector). The results are
+  // identical to the scalar version, but the conversion has no data dependent
+  // branches so that the compiler can vectorize it.
+  void IntegerVectorsToQuantizedOctahedralCoords(const int32_t *int_vecs,
+                                                 int num_vectors,
+                                                 int32_t *out_coords) const {
+    for (int first = 0; first < num_vectors; first += kOctahedralBatchSize) {
+      const int n = std::min(kOctahedralBatchSize, num_vectors - first);
+      const int32_t *const vecs = int_vecs + 3 * first;
+      int32_t *const coords = out_coords + 2 * first;
+      for (int i = 0; i < n; ++i) {
+        IntegerVectorToOctahedralCoordsBranchless(vecs + 3 * i, coords + 2 * i,
+                                                  coords + 2 * i + 1);
+      }
+    }
+  }
+
+  // Batch version of FloatVectorToQuantizedOctahedralCoords(). See
+  // IntegerVectorsToQuantizedOctahedralCoords() for the data layout.
+  template <class T>
+  void FloatVectorsToQuantizedOctahedralCoords(const T *vectors,
+                                               int num_vectors,
+                                               int32_t *out_coords) const {
+    int32_t int_vecs[3 * kOctahedralBatchSize];
+    for (int first = 0; first < num_vectors; first += kOctahedralBatchSize) {
+      const int n = std::min(kOctahedralBatchSize, num_vectors - first);
+      const T *const vecs = vectors + 3 * first;
+      for (int i = 0; i < n; ++i) {
+        FloatVectorToIntegerVectorBranchless(vecs + 3 * i, int_vecs + 3 * i);
+      }
+      int32_t *const coords = out_coords + 2 * first;
+      for (int i = 0; i < n; ++i) {
+        IntegerVectorToOctahedralCoordsBranchless(
+            int_vecs + 3 * i, coords + 2 * i, coords + 2 * i + 1);
+      }
+    }
+  }
+
+  // Batch version of QuantizedOctaherdalCoordsToUnitVector(). Converts
+  // |num_vectors| octahedral coordinates from |coords| (2 values per vector)
+  // to unit vectors stored in |out_vectors| (3 values per vector).
+  template <typename T>
+  void QuantizedOctahedralCoordsToUnitVectors(const int32_t *coords,
+                                              int num_vectors,
+                                              T *out_vectors) const {
+    const T scale = 1.0 / static_cast<T>(max_value_);
+    for (int first = 0; first < num_vectors; first += kOctahedralBatchSize) {
+      const int n = std::min(kOctahedralBatchSize, num_vectors - first);
+      const int32_t *const in = coords + 2 * first;
+      T *const out = out_vectors + 3 * first;
+      for (int i = 0; i < n; ++i) {
+        OctahedralCoordsToUnitVectorBranchless<T>(
+            in[2 * i] * scale, in[2 * i + 1] * scale, out + 3 * i);
+      }
+    }
+  }
+
   // |s| and |t| are expected to be signed values.
   inline bool IsInDiamond(const int32_t &s, const int32_t &t) const {
     // Expect center already at origin.
@@ -333,6 +396,115 @@ class OctahedronToolBox {
   int32_t center_value() const { return center_value_; }
 
  private:
+  // Branch free equivalent of CanonicalizeOctahedralCoords(). The conditions
+  // of the original if-else chain are mutually exclusive once the corner
+  // points are excluded.
+  inline void CanonicalizeOctahedralCoordsBranchless(int32_t s, int32_t t,
+                                                     int32_t *out_s,
+                                                     int32_t *out_t) const {
+    const bool s_zero = s == 0;
+    const bool s_max = s == max_value_;
+    const bool t_zero = t == 0;
+    const bool t_max = t == max_value_;
+    const bool corner = (s_zero & t_zero) | (s_zero & t_max) | (s_max & t_zero);
+    const bool flip_t = (!corner) & ((s_zero & (t > center_value_)) |
+                                     (s_max & (t < center_value_)));
+    const bool flip_s = (!corner) & ((t_max & (s < center_value_)) |
+                                     (t_zero & (s > center_value_)));
+    const int32_t flipped_s = center_value_ - (s - center_value_);
+    const int32_t flipped_t = center_value_ - (t - center_value_);
+    *out_s = corner ? max_value_ : (flip_s ? flipped_s : s);
+    *out_t = corner ? max_value_ : (flip_t ? flipped_t : t);
+  }
+
+  // Branch free equivalent of IntegerVectorToQuantizedOctahedralCoords().
+  inline void IntegerVectorToOctahedralCoordsBranchless(const int32_t *int_vec,
+                                                        int32_t *out_s,
+                                                        int32_t *out_t) const {
+    const int32_t abs_y = std::abs(int_vec[1]);
+    const int32_t abs_z = std::abs(int_vec[2]);
+    // Left hemisphere.
+    const int32_t left_s = int_vec[1] < 0 ? abs_z : max_value_ - abs_z;
+    const int32_t left_t = int_vec[2] < 0 ? abs_y : max_value_ - abs_y;
+    const bool right = int_vec[0] >= 0;
+    CanonicalizeOctahedralCoordsBranchless(
+        right ? int_vec[1] + center_value_ : left_s,
+        right ? int_vec[2] + center_value_ : left_t, out_s, out_t);
+  }
+
+  // Branch free equivalent of the first part of
+  // FloatVectorToQuantizedOctahedralCoords() that projects |vector| to an
+  // integer vector with abs sum equal to the center value.
+  template <class T>
+  inline void FloatVectorToIntegerVectorBranchless(const T *vector,
+                                                   int32_t *int_vec) const {
+    const double abs_sum = std::abs(static_cast<double>(vector[0])) +
+                           std::abs(static_cast<double>(vector[1])) +
+                           std::abs(static_cast<double>(vector[2]));
+    const bool is_valid = abs_sum > 1e-6;
+    const double scale = 1.0 / (is_valid ? abs_sum : 1.0);
+    const double scaled_0 = is_valid ? vector[0] * scale : 1.0;
+    const double scaled_1 = is_valid ? vector[1] * scale : 0.0;
+    const double scaled_2 = is_valid ? vector[2] * scale : 0.0;
+    const int32_t i0 =
+        static_cast<int32_t>(floor(scaled_0 * center_value_ + 0.5));
+    int32_t i1 = static_cast<int32_t>(floor(scaled_1 * center_value_ + 0.5));
+    int32_t i2 = center_value_ - std::abs(i0) - std::abs(i1);
+    // If the sum of first two coordinates is too large, decrease the length
+    // of the second one.
+    const bool too_large = i2 < 0;
+    i1 = too_large ? (i1 > 0 ? i1 + i2 : i1 - i2) : i1;
+    i2 = too_large ? 0 : i2;
+    int_vec[0] = i0;
+    int_vec[1] = i1;
+    int_vec[2] = scaled_2 < 0 ? -i2 : i2;
+  }
+
+  // Branch free equivalent of OctaherdalCoordsToUnitVector().
+  template <typename T>
+  inline void OctahedralCoordsToUnitVectorBranchless(T in_s, T in_t,
+                                                     T *out_vector) const {
+    const T in_spt = in_s + in_t;
+    const T in_smt = in_s - in_t;
+    const bool right = in_spt >= 0.5 && in_spt <= 1.5 && in_smt >= -0.5 &&
+                       in_smt <= 0.5;
+    // Left hemisphere candidates, selected in the same order as in the scalar
+    // version.
+    const bool low = in_spt <= 0.5;
+    const bool high = !low & (in_spt >= 1.5);
+    const bool left = !low & !high & (in_smt <= -0.5);
+    const T low_s = 0.5 - in_t;
+    const T low_t = 0.5 - in_s;
+    const T high_s = 1.5 - in_t;
+    const T high_t = 1.5 - in_s;
+    const T left_s = in_t - 0.5;
+    const T left_t = in_s + 0.5;
+    const T other_s = in_t + 0.5;
+    const T other_t = in_s - 0.5;
+    const T flipped_s =
+        low ? low_s : (high ? high_s : (left ? left_s : other_s));
+    const T flipped_t =
+        low ? low_t : (high ? high_t : (left ? left_t : other_t));
+    const T s = right ? in_s : flipped_s;
+    const T t = right ? in_t : flipped_t;
+    const T spt = right ? in_spt : static_cast<T>(s + t);
+    const T smt = right ? in_smt : static_cast<T>(s - t);
+    const T x_sign = right ? 1.0 : -1.0;
+
+    const T y = 2.0 * s - 1.0;
+    const T z = 2.0 * t - 1.0;
+    const T x = std::min(std::min(2.0 * spt - 1.0, 3.0 - 2.0 * spt),
+                         std::min(2.0 * smt + 1.0, 1.0 - 2.0 * smt)) *
+                x_sign;
+    // Normalize the computed vector.
+    const T normSquared = x * x + y * y + z * z;
+    const bool is_zero = normSquared < 1e-6;
+    const T d = 1.0 / std::sqrt(is_zero ? static_cast<T>(1) : normSquared);
+    out_vector[0] = is_zero ? 0 : x * d;
+    out_vector[1] = is_zero ? 0 : y * d;
+    out_vector[2] = is_zero ? 0 : z * d;
+  }
+
   int32_t quantization_bits_;
   int32_t max_quantized_value_;
   int32_t max_value_;
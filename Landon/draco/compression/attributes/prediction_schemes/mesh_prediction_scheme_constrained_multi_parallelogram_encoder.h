@@ -60,7 +60,12 @@ class MeshPredictionSchemeConstrainedMultiParallelogramEncoder
 
   bool ComputeCorrectionValues(
       const DataTypeT *in_data, CorrType *out_corr, int size,
-      int num_components, const PointIndex *entry_to_point_id_map) override;
+      int num_components,
+      const PointIndex * /* entry_to_point_id_map */) override {
+    return ComputeCorrectionValuesWithSearch(
+        in_data, out_corr, size, num_components,
+        constrained_multi_parallelogram::EXHAUSTIVE_SEARCH);
+  }
 
   bool EncodePredictionData(EncoderBuffer *buffer) override;
 
@@ -72,6 +77,16 @@ class MeshPredictionSchemeConstrainedMultiParallelogramEncoder
     return this->mesh_data().IsInitialized();
   }
 
+ protected:
+  typedef constrained_multi_parallelogram::SearchMode SearchMode;
+
+  // Computes the correction values like ComputeCorrectionValues(), selecting
+  // the used parallelograms of each vertex with |search_mode|.
+  bool ComputeCorrectionValuesWithSearch(const DataTypeT *in_data,
+                                         CorrType *out_corr, int size,
+                                         int num_components,
+                                         SearchMode search_mode);
+
  private:
   // Function used to compute number of bits needed to store overhead of the
   // predictor. In this case, we consider overhead to be all bits that mark
@@ -148,6 +163,41 @@ class MeshPredictionSchemeConstrainedMultiParallelogramEncoder
   typedef constrained_multi_parallelogram::Mode Mode;
   static constexpr int kMaxNumParallelograms =
       constrained_multi_parallelogram::kMaxNumParallelograms;
+  // Maximum number of configurations of the available parallelograms
+  // (including the configuration with no used parallelogram).
+  static constexpr int kMaxNumConfigurations = 1 << kMaxNumParallelograms;
+
+  // Stores all configurations that use at least one of |num_parallelograms|
+  // parallelograms into |out_configurations| in the order in which they are
+  // evaluated by the exhaustive search, i.e., by the number of used
+  // parallelograms and then by the permutations of the excluded
+  // parallelograms. The order matters because ties are resolved in favor of
+  // the first evaluated configuration. Returns the number of configurations.
+  static int ComputeConfigurationOrder(int num_parallelograms,
+                                       uint8_t *out_configurations) {
+    bool excluded_parallelograms[kMaxNumParallelograms];
+    int num_configurations = 0;
+    for (int num_used_parallelograms = 1;
+         num_used_parallelograms <= num_parallelograms;
+         ++num_used_parallelograms) {
+      std::fill(excluded_parallelograms,
+                excluded_parallelograms + num_parallelograms, true);
+      std::fill(excluded_parallelograms,
+                excluded_parallelograms + num_used_parallelograms, false);
+      do {
+        uint8_t configuration = 0;
+        for (int j = 0; j < num_parallelograms; ++j) {
+          if (!excluded_parallelograms[j]) {
+            configuration |= (1 << j);
+          }
+        }
+        out_configurations[num_configurations++] = configuration;
+      } while (std::next_permutation(
+          excluded_parallelograms,
+          excluded_parallelograms + num_parallelograms));
+    }
+    return num_configurations;
+  }
   // Crease edges are used to store whether any given edge should be used for
   // parallelogram prediction or not. New values are added in the order in which
   // the edges are processed. For better compression, the flags are stored in
@@ -167,40 +217,37 @@ class MeshPredictionSchemeConstrainedMultiParallelogramEncoder
 template <typename DataTypeT, class TransformT, class MeshDataT>
 bool MeshPredictionSchemeConstrainedMultiParallelogramEncoder<
     DataTypeT, TransformT, MeshDataT>::
-    ComputeCorrectionValues(const DataTypeT *in_data, CorrType *out_corr,
-                            int size, int num_components,
-                            const PointIndex * /* entry_to_point_id_map */) {
+    ComputeCorrectionValuesWithSearch(const DataTypeT *in_data,
+                                      CorrType *out_corr, int size,
+                                      int num_components,
+                                      SearchMode search_mode) {
   this->transform().Init(in_data, size, num_components);
   const CornerTable *const table = this->mesh_data().corner_table();
   const std::vector<int32_t> *const vertex_to_data_map =
       this->mesh_data().vertex_to_data_map();
 
+  // All temporary values are allocated once and reused for every vertex.
   // Predicted values for all simple parallelograms encountered at any given
-  // vertex.
-  std::vector<DataTypeT> pred_vals[kMaxNumParallelograms];
-  for (int i = 0; i < kMaxNumParallelograms; ++i) {
-    pred_vals[i].resize(num_components);
-  }
-  // Used to store predicted value for various multi-parallelogram predictions
-  // (combinations of simple parallelogram predictions).
-  std::vector<DataTypeT> multi_pred_vals(num_components);
+  // vertex. Values of parallelogram |i| start at |i * num_components|.
+  std::unique_ptr<DataTypeT[]> pred_vals(
+      new DataTypeT[kMaxNumParallelograms * num_components]());
+  // Predicted values of all configurations evaluated at the current vertex.
+  // Values of configuration |c| start at |c * num_components|.
+  std::unique_ptr<DataTypeT[]> config_pred_vals(
+      new DataTypeT[kMaxNumConfigurations * num_components]());
+  // Residuals of the currently evaluated and the best configuration.
+  std::unique_ptr<int[]> current_residuals(new int[num_components]());
+  std::unique_ptr<int[]> best_residuals(new int[num_components]());
   entropy_symbols_.resize(num_components);
 
-  // Struct for holding data about prediction configuration for different sets
-  // of used parallelograms.
-  struct PredictionConfiguration {
-    PredictionConfiguration()
-        : error(), configuration(0), num_used_parallelograms(0) {}
-    Error error;
-    uint8_t configuration;  // Bitfield, 1 use parallelogram, 0 don't use it.
-    int num_used_parallelograms;
-    std::vector<DataTypeT> predicted_value;
-    std::vector<int32_t> residuals;
-  };
-
-  // Bit-field used for computing permutations of excluded edges
-  // (parallelograms).
-  bool exluded_parallelograms[kMaxNumParallelograms];
+  // Order in which the exhaustive search evaluates the configurations for
+  // each number of available parallelograms.
+  uint8_t configuration_order[kMaxNumParallelograms][kMaxNumConfigurations];
+  int num_ordered_configurations[kMaxNumParallelograms];
+  for (int i = 0; i < kMaxNumParallelograms; ++i) {
+    num_ordered_configurations[i] =
+        ComputeConfigurationOrder(i + 1, configuration_order[i]);
+  }
 
   // Data about the number of used parallelogram and total number of available
   // parallelogram for each context. Used to compute overhead needed for storing
@@ -208,8 +255,6 @@ bool MeshPredictionSchemeConstrainedMultiParallelogramEncoder<
   int64_t total_used_parallelograms[kMaxNumParallelograms] = {0};
   int64_t total_parallelograms[kMaxNumParallelograms] = {0};
 
-  std::vector<int> current_residuals(num_components);
-
   // We start processing the vertices from the end because this prediction uses
   // data from previous entries that could be overwritten when an entry is
   // processed.
@@ -227,7 +272,7 @@ bool MeshPredictionSchemeConstrainedMultiParallelogramEncoder<
     while (corner_id != kInvalidCornerIndex) {
       if (ComputeParallelogramPrediction(
               p, corner_id, table, *vertex_to_data_map, in_data, num_components,
-              &(pred_vals[num_parallelograms][0]))) {
+              pred_vals.get() + num_parallelograms * num_components)) {
         // Parallelogram prediction applied and stored in
         // |pred_vals[num_parallelograms]|
         ++num_parallelograms;
@@ -256,125 +301,153 @@ bool MeshPredictionSchemeConstrainedMultiParallelogramEncoder<
 
     // Offset to the target (destination) vertex.
     const int dst_offset = p * num_components;
-    Error error;
-
-    // Compute all prediction errors for all possible configurations of
-    // available parallelograms.
-
-    // Variable for holding the best configuration that has been found so far.
-    PredictionConfiguration best_prediction;
-
-    // Compute delta coding error (configuration when no parallelogram is
-    // selected).
     const int src_offset = (p - 1) * num_components;
-    error = ComputeError(in_data + src_offset, in_data + dst_offset,
-                         &current_residuals[0], num_components);
 
+    // The overhead depends only on the number of used parallelograms, so it is
+    // computed once for each possible count.
+    int64_t overhead_bits[kMaxNumParallelograms + 1] = {0};
     if (num_parallelograms > 0) {
-      total_parallelograms[num_parallelograms - 1] += num_parallelograms;
-      const int64_t new_overhead_bits =
-          ComputeOverheadBits(total_used_parallelograms[num_parallelograms - 1],
-                              total_parallelograms[num_parallelograms - 1]);
-      error.num_bits += new_overhead_bits;
+      const int context = num_parallelograms - 1;
+      total_parallelograms[context] += num_parallelograms;
+      for (int i = 0; i <= num_parallelograms; ++i) {
+        overhead_bits[i] =
+            ComputeOverheadBits(total_used_parallelograms[context] + i,
+                                total_parallelograms[context]);
+      }
     }
 
-    best_prediction.error = error;
-    best_prediction.configuration = 0;
-    best_prediction.num_used_parallelograms = 0;
-    best_prediction.predicted_value.assign(
-        in_data + src_offset, in_data + src_offset + num_components);
-    best_prediction.residuals.assign(current_residuals.begin(),
-                                     current_residuals.end());
-
-    // Compute prediction error for different cases of used parallelograms.
-    for (int num_used_parallelograms = 1;
-         num_used_parallelograms <= num_parallelograms;
-         ++num_used_parallelograms) {
-      // Mark all parallelograms as excluded.
-      std::fill(exluded_parallelograms,
-                exluded_parallelograms + num_parallelograms, true);
-      // TODO(draco-eng) maybe this should be another std::fill.
-      // Mark the first |num_used_parallelograms| as not excluded.
-      for (int j = 0; j < num_used_parallelograms; ++j) {
-        exluded_parallelograms[j] = false;
-      }
-      // Permute over the excluded edges and compute error for each
-      // configuration (permutation of excluded parallelograms).
-      do {
-        // Reset the multi-parallelogram predicted values.
-        for (int j = 0; j < num_components; ++j) {
-          multi_pred_vals[j] = 0;
+    // Compute delta coding error (configuration when no parallelogram is
+    // selected). The predicted value of this configuration is the previous
+    // entry.
+    Error best_error = ComputeError(in_data + src_offset, in_data + dst_offset,
+                                    current_residuals.get(), num_components);
+    best_error.num_bits += overhead_bits[0];
+    uint8_t best_configuration = 0;
+    int best_num_used_parallelograms = 0;
+    const DataTypeT *best_pred_vals = in_data + src_offset;
+    std::copy(current_residuals.get(), current_residuals.get() + num_components,
+              best_residuals.get());
+
+    // Configurations evaluated so far at this vertex (bitfields, 1 use
+    // parallelogram, 0 don't use it).
+    uint8_t evaluated_configurations[kMaxNumConfigurations];
+    int evaluated_num_used_parallelograms[kMaxNumConfigurations];
+    int num_evaluated_configurations = 0;
+
+    // Computes the prediction error of |configuration| and updates the best
+    // configuration when the error is lower. Returns true in that case.
+    // Configurations that are dominated by an already evaluated configuration,
+    // i.e. they predict the same value with at most the same overhead, cannot
+    // be better and they are skipped.
+    const auto evaluate_configuration = [&](uint8_t configuration) {
+      int num_used_parallelograms = 0;
+      DataTypeT *const multi_pred_vals =
+          config_pred_vals.get() + configuration * num_components;
+      std::fill(multi_pred_vals, multi_pred_vals + num_components, 0);
+      for (int j = 0; j < num_parallelograms; ++j) {
+        if ((configuration & (1 << j)) == 0) {
+          continue;
         }
-        uint8_t configuration = 0;
-        for (int j = 0; j < num_parallelograms; ++j) {
-          if (exluded_parallelograms[j]) {
-            continue;
-          }
-          for (int c = 0; c < num_components; ++c) {
-            multi_pred_vals[c] += pred_vals[j][c];
-          }
-          // Set jth bit of the configuration.
-          configuration |= (1 << j);
+        const DataTypeT *const vals = pred_vals.get() + j * num_components;
+        for (int c = 0; c < num_components; ++c) {
+          multi_pred_vals[c] += vals[c];
         }
+        ++num_used_parallelograms;
+      }
+      for (int c = 0; c < num_components; ++c) {
+        multi_pred_vals[c] /= num_used_parallelograms;
+      }
+      const int64_t config_overhead_bits =
+          overhead_bits[num_used_parallelograms];
+      if (overhead_bits[0] <= config_overhead_bits &&
+          std::equal(multi_pred_vals, multi_pred_vals + num_components,
+                     in_data + src_offset)) {
+        return false;
+      }
+      for (int i = 0; i < num_evaluated_configurations; ++i) {
+        const DataTypeT *const other_vals =
+            config_pred_vals.get() +
+            evaluated_configurations[i] * num_components;
+        if (overhead_bits[evaluated_num_used_parallelograms[i]] <=
+                config_overhead_bits &&
+            std::equal(multi_pred_vals, multi_pred_vals + num_components,
+                       other_vals)) {
+          return false;
+        }
+      }
+      evaluated_configurations[num_evaluated_configurations] = configuration;
+      evaluated_num_used_parallelograms[num_evaluated_configurations++] =
+          num_used_parallelograms;
+
+      Error error = ComputeError(multi_pred_vals, in_data + dst_offset,
+                                 current_residuals.get(), num_components);
+      error.num_bits += config_overhead_bits;
+      if (!(error < best_error)) {
+        return false;
+      }
+      best_error = error;
+      best_configuration = configuration;
+      best_num_used_parallelograms = num_used_parallelograms;
+      best_pred_vals = multi_pred_vals;
+      std::copy(current_residuals.get(),
+                current_residuals.get() + num_components,
+                best_residuals.get());
+      return true;
+    };
 
-        for (int j = 0; j < num_components; ++j) {
-          multi_pred_vals[j] /= num_used_parallelograms;
+    if (num_parallelograms > 0) {
+      if (search_mode == SearchMode::EXHAUSTIVE_SEARCH) {
+        // Compute prediction error for all configurations of used
+        // parallelograms.
+        const uint8_t *const configurations =
+            configuration_order[num_parallelograms - 1];
+        for (int i = 0; i < num_ordered_configurations[num_parallelograms - 1];
+             ++i) {
+          evaluate_configuration(configurations[i]);
         }
-        error = ComputeError(multi_pred_vals.data(), in_data + dst_offset,
-                             &current_residuals[0], num_components);
-        if (num_parallelograms > 0) {
-          const int64_t new_overhead_bits = ComputeOverheadBits(
-              total_used_parallelograms[num_parallelograms - 1] +
-                  num_used_parallelograms,
-              total_parallelograms[num_parallelograms - 1]);
-
-          // Add overhead bits to the total error.
-          error.num_bits += new_overhead_bits;
+      } else {
+        // Start with all single parallelograms and then keep adding the
+        // parallelogram that improves the prediction the most.
+        for (int j = 0; j < num_parallelograms; ++j) {
+          evaluate_configuration(1 << j);
         }
-        if (error < best_prediction.error) {
-          best_prediction.error = error;
-          best_prediction.configuration = configuration;
-          best_prediction.num_used_parallelograms = num_used_parallelograms;
-          best_prediction.predicted_value.assign(multi_pred_vals.begin(),
-                                                 multi_pred_vals.end());
-          best_prediction.residuals.assign(current_residuals.begin(),
-                                           current_residuals.end());
+        uint8_t current_configuration = best_configuration;
+        while (current_configuration != 0) {
+          for (int j = 0; j < num_parallelograms; ++j) {
+            if ((current_configuration & (1 << j)) == 0) {
+              evaluate_configuration(current_configuration | (1 << j));
+            }
+          }
+          if (best_configuration == current_configuration) {
+            break;  // No configuration with more parallelograms was better.
+          }
+          current_configuration = best_configuration;
         }
-      } while (std::next_permutation(
-          exluded_parallelograms, exluded_parallelograms + num_parallelograms));
-    }
-    if (num_parallelograms > 0) {
+      }
       total_used_parallelograms[num_parallelograms - 1] +=
-          best_prediction.num_used_parallelograms;
+          best_num_used_parallelograms;
     }
 
     // Update the entropy stream by adding selected residuals as symbols to the
     // stream.
     for (int i = 0; i < num_components; ++i) {
-      entropy_symbols_[i] =
-          ConvertSignedIntToSymbol(best_prediction.residuals[i]);
+      entropy_symbols_[i] = ConvertSignedIntToSymbol(best_residuals[i]);
     }
     entropy_tracker_.Push(entropy_symbols_.data(), num_components);
 
     for (int i = 0; i < num_parallelograms; ++i) {
-      if ((best_prediction.configuration & (1 << i)) == 0) {
-        // Parallelogram not used, mark the edge as crease.
-        is_crease_edge_[num_parallelograms - 1].push_back(true);
-      } else {
-        // Parallelogram used. Add it to the predicted value and mark the
-        // edge as not a crease.
-        is_crease_edge_[num_parallelograms - 1].push_back(false);
-      }
+      // Parallelograms that are not used are marked as crease edges.
+      is_crease_edge_[num_parallelograms - 1].push_back(
+          (best_configuration & (1 << i)) == 0);
     }
-    this->transform().ComputeCorrection(in_data + dst_offset,
-                                        best_prediction.predicted_value.data(),
+    this->transform().ComputeCorrection(in_data + dst_offset, best_pred_vals,
                                         out_corr + dst_offset);
   }
   // First element is always fixed because it cannot be predicted.
   for (int i = 0; i < num_components; ++i) {
-    pred_vals[0][i] = static_cast<DataTypeT>(0);
+    pred_vals[i] = static_cast<DataTypeT>(0);
   }
-  this->transform().ComputeCorrection(in_data, pred_vals[0].data(), out_corr);
+  this->transform().ComputeCorrection(in_data, pred_vals.get(), out_corr);
   return true;
 }
 
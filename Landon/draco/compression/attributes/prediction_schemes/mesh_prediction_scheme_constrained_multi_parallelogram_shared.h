@@ -28,6 +28,16 @@ enum Mode {
 
 static constexpr int kMaxNumParallelograms = 4;
 
+// Strategy used by the encoder to select the used parallelograms. The search
+// mode is not stored in the bitstream and the decoder works with any of them.
+enum SearchMode {
+  // Evaluates all configurations of the available parallelograms.
+  EXHAUSTIVE_SEARCH = 0,
+  // Starts from the best single parallelogram and keeps adding parallelograms
+  // while the prediction improves. Faster but can miss the best configuration.
+  GREEDY_SEARCH,
+};
+
 }  // namespace constrained_multi_parallelogram
 }  // namespace draco
 
@@ -107,30 +107,35 @@ bool MeshPredictionSchemeGeometricNormalDecoder<
   // Expecting in_data in octahedral coordinates, i.e., portable attribute.
   DRACO_DCHECK_EQ(num_components, 2);
 
+  // Predicted normals depend only on the positions, so they are computed for
+  // all entries at once.
+  std::vector<int32_t> pred_normals;
+  predictor_.ComputePredictedValues(&pred_normals);
   const int corner_map_size =
       static_cast<int>(this->mesh_data().data_to_corner_map()->size());
-
-  VectorD<int32_t, 3> pred_normal_3d;
-  int32_t pred_normal_oct[2];
-
   for (int data_id = 0; data_id < corner_map_size; ++data_id) {
-    const CornerIndex corner_id =
-        this->mesh_data().data_to_corner_map()->at(data_id);
-    predictor_.ComputePredictedValue(corner_id, pred_normal_3d.data());
-
-    // Compute predicted octahedral coordinates.
-    octahedron_tool_box_.CanonicalizeIntegerVector(pred_normal_3d.data());
-    DRACO_DCHECK_EQ(pred_normal_3d.AbsSum(),
+    int32_t *const pred_normal_3d = &pred_normals[3 * data_id];
+    octahedron_tool_box_.CanonicalizeIntegerVector(pred_normal_3d);
+    DRACO_DCHECK_EQ(std::abs(pred_normal_3d[0]) + std::abs(pred_normal_3d[1]) +
+                        std::abs(pred_normal_3d[2]),
                     octahedron_tool_box_.center_value());
     if (flip_normal_bit_decoder_.DecodeNextBit()) {
-      pred_normal_3d = -pred_normal_3d;
+      pred_normal_3d[0] = -pred_normal_3d[0];
+      pred_normal_3d[1] = -pred_normal_3d[1];
+      pred_normal_3d[2] = -pred_normal_3d[2];
     }
-    octahedron_tool_box_.IntegerVectorToQuantizedOctahedralCoords(
-        pred_normal_3d.data(), pred_normal_oct, pred_normal_oct + 1);
+  }
+
+  // Compute predicted octahedral coordinates.
+  std::vector<int32_t> pred_normals_oct(2 * corner_map_size);
+  octahedron_tool_box_.IntegerVectorsToQuantizedOctahedralCoords(
+      pred_normals.data(), corner_map_size, pred_normals_oct.data());
 
+  for (int data_id = 0; data_id < corner_map_size; ++data_id) {
     const int data_offset = data_id * 2;
-    this->transform().ComputeOriginalValue(
-        pred_normal_oct, in_corr + data_offset, out_data + data_offset);
+    this->transform().ComputeOriginalValue(&pred_normals_oct[data_offset],
+                                           in_corr + data_offset,
+                                           out_data + data_offset);
   }
   flip_normal_bit_decoder_.EndDecoding();
   return true;
@@ -106,40 +106,46 @@ bool MeshPredictionSchemeGeometricNormalEncoder<DataTypeT, TransformT,
 
   flip_normal_bit_encoder_.StartEncoding();
 
+  // Predicted normals depend only on the positions, so they are computed for
+  // all entries at once.
+  std::vector<int32_t> pred_normals;
+  predictor_.ComputePredictedValues(&pred_normals);
   const int corner_map_size =
       static_cast<int>(this->mesh_data().data_to_corner_map()->size());
+  for (int data_id = 0; data_id < corner_map_size; ++data_id) {
+    int32_t *const pred_normal_3d = &pred_normals[3 * data_id];
+    octahedron_tool_box_.CanonicalizeIntegerVector(pred_normal_3d);
+    DRACO_DCHECK_EQ(std::abs(pred_normal_3d[0]) + std::abs(pred_normal_3d[1]) +
+                        std::abs(pred_normal_3d[2]),
+                    octahedron_tool_box_.center_value());
+  }
+
+  // Compute octahedral coordinates for both possible directions.
+  std::vector<int32_t> pos_pred_normals_oct(2 * corner_map_size);
+  std::vector<int32_t> neg_pred_normals_oct(2 * corner_map_size);
+  octahedron_tool_box_.IntegerVectorsToQuantizedOctahedralCoords(
+      pred_normals.data(), corner_map_size, pos_pred_normals_oct.data());
+  for (int32_t &value : pred_normals) {
+    value = -value;
+  }
+  octahedron_tool_box_.IntegerVectorsToQuantizedOctahedralCoords(
+      pred_normals.data(), corner_map_size, neg_pred_normals_oct.data());
 
-  VectorD<int32_t, 3> pred_normal_3d;
-  VectorD<int32_t, 2> pos_pred_normal_oct;
-  VectorD<int32_t, 2> neg_pred_normal_oct;
   VectorD<int32_t, 2> pos_correction;
   VectorD<int32_t, 2> neg_correction;
   for (int data_id = 0; data_id < corner_map_size; ++data_id) {
-    const CornerIndex corner_id =
-        this->mesh_data().data_to_corner_map()->at(data_id);
-    predictor_.ComputePredictedValue(corner_id, pred_normal_3d.data());
-
-    // Compute predicted octahedral coordinates.
-    octahedron_tool_box_.CanonicalizeIntegerVector(pred_normal_3d.data());
-    DRACO_DCHECK_EQ(pred_normal_3d.AbsSum(),
-                    octahedron_tool_box_.center_value());
-
-    // Compute octahedral coordinates for both possible directions.
-    octahedron_tool_box_.IntegerVectorToQuantizedOctahedralCoords(
-        pred_normal_3d.data(), pos_pred_normal_oct.data(),
-        pos_pred_normal_oct.data() + 1);
-    pred_normal_3d = -pred_normal_3d;
-    octahedron_tool_box_.IntegerVectorToQuantizedOctahedralCoords(
-        pred_normal_3d.data(), neg_pred_normal_oct.data(),
-        neg_pred_normal_oct.data() + 1);
+    const int32_t *const pos_pred_normal_oct =
+        &pos_pred_normals_oct[2 * data_id];
+    const int32_t *const neg_pred_normal_oct =
+        &neg_pred_normals_oct[2 * data_id];
 
     // Choose the one with the best correction value.
     const int data_offset = data_id * 2;
     this->transform().ComputeCorrection(in_data + data_offset,
-                                        pos_pred_normal_oct.data(),
+                                        pos_pred_normal_oct,
                                         pos_correction.data());
     this->transform().ComputeCorrection(in_data + data_offset,
-                                        neg_pred_normal_oct.data(),
+                                        neg_pred_normal_oct,
                                         neg_correction.data());
     pos_correction[0] = octahedron_tool_box_.ModMax(pos_correction[0]);
     pos_correction[1] = octahedron_tool_box_.ModMax(pos_correction[1]);
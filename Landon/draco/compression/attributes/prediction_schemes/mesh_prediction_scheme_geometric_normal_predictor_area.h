@@ -15,6 +15,8 @@
 #ifndef DRACO_COMPRESSION_ATTRIBUTES_PREDICTION_SCHEMES_MESH_PREDICTION_SCHEME_GEOMETRIC_NORMAL_PREDICTOR_AREA_H_
 #define DRACO_COMPRESSION_ATTRIBUTES_PREDICTION_SCHEMES_MESH_PREDICTION_SCHEME_GEOMETRIC_NORMAL_PREDICTOR_AREA_H_
 
+#include <vector>
+
 #include "draco/compression/attributes/prediction_schemes/mesh_prediction_scheme_geometric_normal_predictor_base.h"
 
 namespace draco {
@@ -72,7 +74,108 @@ class MeshPredictionSchemeGeometricNormalPredictorArea
       normal = normal + cross;
       cit.Next();
     }
+    StorePrediction(normal, prediction);
+  }
+
+  // Computes predicted values for all data entries of the mesh data. Values
+  // of entry |i| are stored at |3 * i| in |predictions|. The result is the
+  // same as calling ComputePredictedValue() for the corner of each entry, but
+  // in the TRIANGLE_AREA mode the normal of each face is computed just once
+  // and the vertex normals are accumulated from the face normals.
+  void ComputePredictedValues(std::vector<DataTypeT> *predictions) {
+    DRACO_DCHECK(this->IsInitialized());
+    const std::vector<CornerIndex> &data_to_corner_map =
+        *this->mesh_data_.data_to_corner_map();
+    const int num_entries = static_cast<int>(data_to_corner_map.size());
+    predictions->resize(3 * num_entries);
+    if (this->normal_prediction_mode_ != TRIANGLE_AREA) {
+      for (int i = 0; i < num_entries; ++i) {
+        ComputePredictedValue(data_to_corner_map[i], &(*predictions)[3 * i]);
+      }
+      return;
+    }
+    typedef typename MeshDataT::CornerTable CornerTable;
+    const CornerTable *const corner_table = this->mesh_data_.corner_table();
+    const std::vector<int32_t> &vertex_to_data_map =
+        *this->mesh_data_.vertex_to_data_map();
+    const int num_vertices = static_cast<int>(vertex_to_data_map.size());
+    const int num_faces = corner_table->num_faces();
+
+    // Gather the positions of all vertices.
+    std::vector<int64_t> positions(3 * num_vertices, 0);
+    for (int v = 0; v < num_vertices; ++v) {
+      if (vertex_to_data_map[v] < 0) {
+        continue;
+      }
+      const VectorD<int64_t, 3> pos =
+          this->GetPositionForDataId(vertex_to_data_map[v]);
+      positions[3 * v] = pos[0];
+      positions[3 * v + 1] = pos[1];
+      positions[3 * v + 2] = pos[2];
+    }
 
+    // Phase 1: Area weighted normals of all faces. The cross product of the
+    // edges is the same for all three corners of a face.
+    std::vector<int64_t> face_normals(3 * num_faces, 0);
+    for (int f = 0; f < num_faces; ++f) {
+      const CornerIndex first_corner(3 * f);
+      const VertexIndex v0 = corner_table->Vertex(first_corner);
+      const VertexIndex v1 = corner_table->Vertex(first_corner + 1);
+      const VertexIndex v2 = corner_table->Vertex(first_corner + 2);
+      if (v0 == kInvalidVertexIndex || v1 == kInvalidVertexIndex ||
+          v2 == kInvalidVertexIndex) {
+        continue;
+      }
+      const int64_t *const p0 = &positions[3 * v0.value()];
+      const int64_t *const p1 = &positions[3 * v1.value()];
+      const int64_t *const p2 = &positions[3 * v2.value()];
+      const int64_t dn[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+      const int64_t dp[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+      int64_t *const n = &face_normals[3 * f];
+      n[0] = dn[1] * dp[2] - dn[2] * dp[1];
+      n[1] = dn[2] * dp[0] - dn[0] * dp[2];
+      n[2] = dn[0] * dp[1] - dn[1] * dp[0];
+    }
+
+    // Phase 2: Sum the normals of all faces around each vertex.
+    std::vector<int64_t> vertex_normals(3 * num_vertices, 0);
+    for (int c = 0; c < 3 * num_faces; ++c) {
+      const VertexIndex v = corner_table->Vertex(CornerIndex(c));
+      if (v == kInvalidVertexIndex) {
+        continue;
+      }
+      const int64_t *const n = &face_normals[3 * (c / 3)];
+      int64_t *const vn = &vertex_normals[3 * v.value()];
+      vn[0] += n[0];
+      vn[1] += n[1];
+      vn[2] += n[2];
+    }
+
+    for (int i = 0; i < num_entries; ++i) {
+      const int v = corner_table->Vertex(data_to_corner_map[i]).value();
+      const VectorD<int64_t, 3> normal(vertex_normals[3 * v],
+                                 vertex_normals[3 * v + 1],
+                                 vertex_normals[3 * v + 2]);
+      StorePrediction(normal, &(*predictions)[3 * i]);
+    }
+  }
+
+  bool SetNormalPredictionMode(NormalPredictionMode mode) override {
+    if (mode == ONE_TRIANGLE) {
+      this->normal_prediction_mode_ = mode;
+      return true;
+    } else if (mode == TRIANGLE_AREA) {
+      this->normal_prediction_mode_ = mode;
+      return true;
+    }
+    return false;
+  }
+
+ private:
+  // Scales the accumulated |normal| down to a range representable by int32_t
+  // and stores it in |prediction|.
+  void StorePrediction(VectorD<int64_t, 3> normal,
+                       DataTypeT *prediction) const {
     // Convert to int32_t, make sure entries are not too large.
     constexpr int64_t upper_bound = 1 << 29;
     if (this->normal_prediction_mode_ == ONE_TRIANGLE) {
@@ -93,16 +196,6 @@ class MeshPredictionSchemeGeometricNormalPredictorArea
     prediction[1] = static_cast<int32_t>(normal[1]);
     prediction[2] = static_cast<int32_t>(normal[2]);
   }
-  bool SetNormalPredictionMode(NormalPredictionMode mode) override {
-    if (mode == ONE_TRIANGLE) {
-      this->normal_prediction_mode_ = mode;
-      return true;
-    } else if (mode == TRIANGLE_AREA) {
-      this->normal_prediction_mode_ = mode;
-      return true;
-    }
-    return false;
-  }
 };
 
 }  // namespace draco
@@ -0,0 +1,61 @@
+// Copyright 2020 The Draco Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DRACO_COMPRESSION_ATTRIBUTES_PREDICTION_SCHEMES_MESH_PREDICTION_SCHEME_GREEDY_CONSTRAINED_MULTI_PARALLELOGRAM_ENCODER_H_
+#define DRACO_COMPRESSION_ATTRIBUTES_PREDICTION_SCHEMES_MESH_PREDICTION_SCHEME_GREEDY_CONSTRAINED_MULTI_PARALLELOGRAM_ENCODER_H_
+
+#include "draco/compression/attributes/prediction_schemes/mesh_prediction_scheme_constrained_multi_parallelogram_encoder.h"
+
+namespace draco {
+
+// Constrained multi-parallelogram encoder that selects the used parallelograms
+// of each vertex with a greedy search instead of evaluating all their
+// configurations. The search starts from the best single parallelogram and
+// keeps adding the parallelogram that improves the prediction the most until
+// no addition helps. It is faster than the exhaustive search on vertices with
+// many parallelograms, but it can miss the best configuration. The encoded
+// data has the same format as the data of the exhaustive search, so it is
+// decoded by MeshPredictionSchemeConstrainedMultiParallelogramDecoder.
+template <typename DataTypeT, class TransformT, class MeshDataT>
+class MeshPredictionSchemeGreedyConstrainedMultiParallelogramEncoder
+    : public MeshPredictionSchemeConstrainedMultiParallelogramEncoder<
+          DataTypeT, TransformT, MeshDataT> {
+ public:
+  using CorrType =
+      typename PredictionSchemeEncoder<DataTypeT, TransformT>::CorrType;
+
+  explicit MeshPredictionSchemeGreedyConstrainedMultiParallelogramEncoder(
+      const PointAttribute *attribute)
+      : MeshPredictionSchemeConstrainedMultiParallelogramEncoder<
+            DataTypeT, TransformT, MeshDataT>(attribute) {}
+  MeshPredictionSchemeGreedyConstrainedMultiParallelogramEncoder(
+      const PointAttribute *attribute, const TransformT &transform,
+      const MeshDataT &mesh_data)
+      : MeshPredictionSchemeConstrainedMultiParallelogramEncoder<
+            DataTypeT, TransformT, MeshDataT>(attribute, transform,
+                                              mesh_data) {}
+
+  bool ComputeCorrectionValues(
+      const DataTypeT *in_data, CorrType *out_corr, int size,
+      int num_components,
+      const PointIndex * /* entry_to_point_id_map */) override {
+    return this->ComputeCorrectionValuesWithSearch(
+        in_data, out_corr, size, num_components,
+        constrained_multi_parallelogram::GREEDY_SEARCH);
+  }
+};
+
+}  // namespace draco
+
+#endif  // DRACO_COMPRESSION_ATTRIBUTES_PREDICTION_SCHEMES_MESH_PREDICTION_SCHEME_GREEDY_CONSTRAINED_MULTI_PARALLELOGRAM_ENCODER_H_
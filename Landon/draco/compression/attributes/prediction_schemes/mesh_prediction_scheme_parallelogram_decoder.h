@@ -70,24 +70,42 @@ bool MeshPredictionSchemeParallelogramDecoder<DataTypeT, TransformT,
   // Restore the first value.
   this->transform().ComputeOriginalValue(pred_vals.get(), in_corr, out_data);
 
-  const int corner_map_size =
-      static_cast<int>(this->mesh_data().data_to_corner_map()->size());
-  for (int p = 1; p < corner_map_size; ++p) {
-    const CornerIndex corner_id = this->mesh_data().data_to_corner_map()->at(p);
-    const int dst_offset = p * num_components;
-    if (!ComputeParallelogramPrediction(p, corner_id, table,
-                                        *vertex_to_data_map, out_data,
-                                        num_components, pred_vals.get())) {
-      // Parallelogram could not be computed, Possible because some of the
-      // vertices are not valid (not encoded yet).
-      // We use the last encoded point as a reference (delta coding).
-      const int src_offset = (p - 1) * num_components;
-      this->transform().ComputeOriginalValue(
-          out_data + src_offset, in_corr + dst_offset, out_data + dst_offset);
-    } else {
-      // Apply the parallelogram prediction.
-      this->transform().ComputeOriginalValue(
-          pred_vals.get(), in_corr + dst_offset, out_data + dst_offset);
+  // The connectivity of all entries is known up front, so the parallelogram
+  // entries are gathered for whole blocks before the values are decoded. The
+  // predictions themselves depend on previously decoded values and are
+  // evaluated one entry at a time.
+  const std::vector<CornerIndex> *const data_to_corner_map =
+      this->mesh_data().data_to_corner_map();
+  const int corner_map_size = static_cast<int>(data_to_corner_map->size());
+  ParallelogramPredictionBlock block;
+  for (int block_begin = 1; block_begin < corner_map_size;
+       block_begin += kParallelogramPredictionBlockSize) {
+    const int block_size = std::min(kParallelogramPredictionBlockSize,
+                                    corner_map_size - block_begin);
+    GatherParallelogramPredictionBlock(block_begin, block_size,
+                                       *data_to_corner_map, table,
+                                       *vertex_to_data_map, &block);
+    for (int i = 0; i < block_size; ++i) {
+      const int dst_offset = (block_begin + i) * num_components;
+      if (!block.is_valid[i]) {
+        // Parallelogram could not be computed, Possible because some of the
+        // vertices are not valid (not encoded yet).
+        // We use the last encoded point as a reference (delta coding).
+        const int src_offset = dst_offset - num_components;
+        this->transform().ComputeOriginalValue(
+            out_data + src_offset, in_corr + dst_offset, out_data + dst_offset);
+      } else {
+        // Apply the parallelogram prediction.
+        const int v_opp_off = block.opp_entries[i] * num_components;
+        const int v_next_off = block.next_entries[i] * num_components;
+        const int v_prev_off = block.prev_entries[i] * num_components;
+        for (int c = 0; c < num_components; ++c) {
+          pred_vals[c] = (out_data[v_next_off + c] + out_data[v_prev_off + c]) -
+                         out_data[v_opp_off + c];
+        }
+        this->transform().ComputeOriginalValue(
+            pred_vals.get(), in_corr + dst_offset, out_data + dst_offset);
+      }
     }
   }
   return true;
@@ -70,32 +70,46 @@ bool MeshPredictionSchemeParallelogramEncoder<DataTypeT, TransformT,
                             int size, int num_components,
                             const PointIndex * /* entry_to_point_id_map */) {
   this->transform().Init(in_data, size, num_components);
-  // For storage of prediction values (already initialized to zero).
-  std::unique_ptr<DataTypeT[]> pred_vals(new DataTypeT[num_components]());
+  // For storage of prediction values of one block of entries.
+  std::unique_ptr<DataTypeT[]> pred_vals(
+      new DataTypeT[kParallelogramPredictionBlockSize * num_components]());
+  ParallelogramPredictionBlock block;
 
-  // We start processing from the end because this prediction uses data from
-  // previous entries that could be overwritten when an entry is processed.
+  // All data is known on the encoder side so the predictions are computed for
+  // whole blocks of entries at once. Blocks are processed from the end because
+  // this prediction uses data from previous entries that could be overwritten
+  // when an entry is processed.
   const CornerTable *const table = this->mesh_data().corner_table();
   const std::vector<int32_t> *const vertex_to_data_map =
       this->mesh_data().vertex_to_data_map();
-  for (int p =
-           static_cast<int>(this->mesh_data().data_to_corner_map()->size() - 1);
-       p > 0; --p) {
-    const CornerIndex corner_id = this->mesh_data().data_to_corner_map()->at(p);
-    const int dst_offset = p * num_components;
-    if (!ComputeParallelogramPrediction(p, corner_id, table,
-                                        *vertex_to_data_map, in_data,
-                                        num_components, pred_vals.get())) {
-      // Parallelogram could not be computed, Possible because some of the
-      // vertices are not valid (not encoded yet).
-      // We use the last encoded point as a reference (delta coding).
-      const int src_offset = (p - 1) * num_components;
-      this->transform().ComputeCorrection(
-          in_data + dst_offset, in_data + src_offset, out_corr + dst_offset);
-    } else {
-      // Apply the parallelogram prediction.
-      this->transform().ComputeCorrection(in_data + dst_offset, pred_vals.get(),
-                                          out_corr + dst_offset);
+  const std::vector<CornerIndex> *const data_to_corner_map =
+      this->mesh_data().data_to_corner_map();
+  for (int block_end = static_cast<int>(data_to_corner_map->size());
+       block_end > 1; block_end -= kParallelogramPredictionBlockSize) {
+    const int block_begin =
+        std::max(1, block_end - kParallelogramPredictionBlockSize);
+    const int block_size = block_end - block_begin;
+    GatherParallelogramPredictionBlock(block_begin, block_size,
+                                       *data_to_corner_map, table,
+                                       *vertex_to_data_map, &block);
+    ComputeParallelogramPredictionBlock(block, block_size, num_components,
+                                        in_data, pred_vals.get());
+    for (int p = block_end - 1; p >= block_begin; --p) {
+      const int dst_offset = p * num_components;
+      if (!block.is_valid[p - block_begin]) {
+        // Parallelogram could not be computed, Possible because some of the
+        // vertices are not valid (not encoded yet).
+        // We use the last encoded point as a reference (delta coding).
+        const int src_offset = (p - 1) * num_components;
+        this->transform().ComputeCorrection(
+            in_data + dst_offset, in_data + src_offset, out_corr + dst_offset);
+      } else {
+        // Apply the parallelogram prediction.
+        this->transform().ComputeCorrection(
+            in_data + dst_offset,
+            pred_vals.get() + (p - block_begin) * num_components,
+            out_corr + dst_offset);
+      }
     }
   }
   // First element is always fixed because it cannot be predicted.
@@ -17,6 +17,9 @@
 #ifndef DRACO_COMPRESSION_ATTRIBUTES_PREDICTION_SCHEMES_MESH_PREDICTION_SCHEME_PARALLELOGRAM_SHARED_H_
 #define DRACO_COMPRESSION_ATTRIBUTES_PREDICTION_SCHEMES_MESH_PREDICTION_SCHEME_PARALLELOGRAM_SHARED_H_
 
+#include <algorithm>
+#include <vector>
+
 #include "draco/mesh/corner_table.h"
 #include "draco/mesh/mesh.h"
 
@@ -68,6 +71,119 @@ inline bool ComputeParallelogramPrediction(
   return false;  // Not all data is available for prediction
 }
 
+// Number of data entries processed together by the batched parallelogram
+// prediction.
+static constexpr int kParallelogramPredictionBlockSize = 256;
+
+// Gathered data entries of the opposite, next and previous vertices of the
+// parallelogram used to predict a block of consecutive data entries.
+struct ParallelogramPredictionBlock {
+  ParallelogramPredictionBlock()
+      : opp_entries(kParallelogramPredictionBlockSize),
+        next_entries(kParallelogramPredictionBlockSize),
+        prev_entries(kParallelogramPredictionBlockSize),
+        is_valid(kParallelogramPredictionBlockSize) {}
+  std::vector<int> opp_entries;
+  std::vector<int> next_entries;
+  std::vector<int> prev_entries;
+  // Set to 0 when the parallelogram prediction can't be used for the entry.
+  // The gathered entries of such entry all point to the first data entry so
+  // that the prediction can be evaluated without branches.
+  std::vector<uint8_t> is_valid;
+};
+
+// Gathers the parallelogram entries of |num_entries| data entries starting at
+// |first_entry| into |block|. |num_entries| must not exceed
+// kParallelogramPredictionBlockSize. The validity of each entry is the same as
+// in ComputeParallelogramPrediction().
+template <class CornerTableT>
+inline void GatherParallelogramPredictionBlock(
+    int first_entry, int num_entries,
+    const std::vector<CornerIndex> &data_to_corner_map,
+    const CornerTableT *table, const std::vector<int32_t> &vertex_to_data_map,
+    ParallelogramPredictionBlock *block) {
+  for (int i = 0; i < num_entries; ++i) {
+    const int data_entry_id = first_entry + i;
+    const CornerIndex oci =
+        table->Opposite(data_to_corner_map[data_entry_id]);
+    int vert_opp = 0, vert_next = 0, vert_prev = 0;
+    bool is_valid = false;
+    if (oci != kInvalidCornerIndex) {
+      GetParallelogramEntries<CornerTableT>(oci, table, vertex_to_data_map,
+                                            &vert_opp, &vert_next, &vert_prev);
+      is_valid = vert_opp < data_entry_id && vert_next < data_entry_id &&
+                 vert_prev < data_entry_id;
+    }
+    if (!is_valid) {
+      vert_opp = vert_next = vert_prev = 0;
+    }
+    block->opp_entries[i] = vert_opp;
+    block->next_entries[i] = vert_next;
+    block->prev_entries[i] = vert_prev;
+    block->is_valid[i] = is_valid;
+  }
+}
+
+// Evaluates next + prev - opp for the first |num_entries| entries of |block|.
+// The loop has no data dependent branches and a fixed trip count of the inner
+// loop, so that the compiler can vectorize it.
+template <int num_components_t, typename DataTypeT>
+inline void ComputeParallelogramPredictionBlock(
+    const ParallelogramPredictionBlock &block, int num_entries,
+    const DataTypeT *in_data, DataTypeT *out_predictions) {
+  const int *const opp_entries = block.opp_entries.data();
+  const int *const next_entries = block.next_entries.data();
+  const int *const prev_entries = block.prev_entries.data();
+  for (int i = 0; i < num_entries; ++i) {
+    const DataTypeT *const opp = in_data + opp_entries[i] * num_components_t;
+    const DataTypeT *const next = in_data + next_entries[i] * num_components_t;
+    const DataTypeT *const prev = in_data + prev_entries[i] * num_components_t;
+    DataTypeT *const out = out_predictions + i * num_components_t;
+    for (int c = 0; c < num_components_t; ++c) {
+      out[c] = (next[c] + prev[c]) - opp[c];
+    }
+  }
+}
+
+// Same as above for a number of components known only at runtime. The common
+// component counts are dispatched to the specialized versions.
+template <typename DataTypeT>
+inline void ComputeParallelogramPredictionBlock(
+    const ParallelogramPredictionBlock &block, int num_entries,
+    int num_components, const DataTypeT *in_data,
+    DataTypeT *out_predictions) {
+  switch (num_components) {
+    case 1:
+      ComputeParallelogramPredictionBlock<1>(block, num_entries, in_data,
+                                             out_predictions);
+      return;
+    case 2:
+      ComputeParallelogramPredictionBlock<2>(block, num_entries, in_data,
+                                             out_predictions);
+      return;
+    case 3:
+      ComputeParallelogramPredictionBlock<3>(block, num_entries, in_data,
+                                             out_predictions);
+      return;
+    case 4:
+      ComputeParallelogramPredictionBlock<4>(block, num_entries, in_data,
+                                             out_predictions);
+      return;
+    default:
+      break;
+  }
+  for (int i = 0; i < num_entries; ++i) {
+    const int opp_off = block.opp_entries[i] * num_components;
+    const int next_off = block.next_entries[i] * num_components;
+    const int prev_off = block.prev_entries[i] * num_components;
+    DataTypeT *const out = out_predictions + i * num_components;
+    for (int c = 0; c < num_components; ++c) {
+      out[c] = (in_data[next_off + c] + in_data[prev_off + c]) -
+               in_data[opp_off + c];
+    }
+  }
+}
+
 }  // namespace draco
 
 #endif  // DRACO_COMPRESSION_ATTRIBUTES_PREDICTION_SCHEMES_MESH_PREDICTION_SCHEME_PARALLELOGRAM_SHARED_H_
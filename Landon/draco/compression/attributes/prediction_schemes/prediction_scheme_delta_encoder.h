@@ -54,9 +54,10 @@ bool PredictionSchemeDeltaEncoder<
                                                     const PointIndex *) {
   this->transform().Init(in_data, size, num_components);
   // Encode data from the back using D(i) = D(i) - D(i - 1).
-  for (int i = size - num_components; i > 0; i -= num_components) {
-    this->transform().ComputeCorrection(
-        in_data + i, in_data + i - num_components, out_corr + i);
+  if (size > num_components) {
+    this->transform().ComputeCorrections(
+        in_data + num_components, in_data, size / num_components - 1,
+        out_corr + num_components);
   }
   // Encode correction for the first element.
   std::unique_ptr<DataTypeT[]> zero_vals(new DataTypeT[num_components]());
@@ -22,6 +22,7 @@
 #ifdef DRACO_NORMAL_ENCODING_SUPPORTED
 #include "draco/compression/attributes/prediction_schemes/mesh_prediction_scheme_geometric_normal_encoder.h"
 #endif
+#include "draco/compression/attributes/prediction_schemes/mesh_prediction_scheme_greedy_constrained_multi_parallelogram_encoder.h"
 #include "draco/compression/attributes/prediction_schemes/mesh_prediction_scheme_multi_parallelogram_encoder.h"
 #include "draco/compression/attributes/prediction_schemes/mesh_prediction_scheme_parallelogram_encoder.h"
 #include "draco/compression/attributes/prediction_schemes/mesh_prediction_scheme_tex_coords_encoder.h"
@@ -74,6 +75,29 @@ struct MeshPredictionSchemeEncoderFactory {
   }
 };
 
+// Factory class for creating mesh prediction schemes that select the used
+// parallelograms of MESH_PREDICTION_CONSTRAINED_MULTI_PARALLELOGRAM with a
+// greedy search. It is used when the attribute option
+// "approximate_multi_parallelogram_search" is set. Other prediction schemes
+// are created by MeshPredictionSchemeEncoderFactory.
+template <typename DataTypeT>
+struct MeshPredictionSchemeGreedyEncoderFactory {
+  template <class TransformT, class MeshDataT>
+  std::unique_ptr<PredictionSchemeEncoder<DataTypeT, TransformT>> operator()(
+      PredictionSchemeMethod method, const PointAttribute *attribute,
+      const TransformT &transform, const MeshDataT &mesh_data,
+      uint16_t bitstream_version) {
+    if (method == MESH_PREDICTION_CONSTRAINED_MULTI_PARALLELOGRAM) {
+      return std::unique_ptr<PredictionSchemeEncoder<DataTypeT, TransformT>>(
+          new MeshPredictionSchemeGreedyConstrainedMultiParallelogramEncoder<
+              DataTypeT, TransformT, MeshDataT>(attribute, transform,
+                                                mesh_data));
+    }
+    return MeshPredictionSchemeEncoderFactory<DataTypeT>()(
+        method, attribute, transform, mesh_data, bitstream_version);
+  }
+};
+
 // Creates a prediction scheme for a given encoder and given prediction method.
 // The prediction schemes are automatically initialized with encoder specific
 // data if needed.
@@ -97,10 +121,19 @@ CreatePredictionSchemeForEncoder(PredictionSchemeMethod method, int att_id,
     // template nature of the prediction schemes).
     const MeshEncoder *const mesh_encoder =
         static_cast<const MeshEncoder *>(encoder);
-    auto ret = CreateMeshPredictionScheme<
-        MeshEncoder, PredictionSchemeEncoder<DataTypeT, TransformT>,
-        MeshPredictionSchemeEncoderFactory<DataTypeT>>(
-        mesh_encoder, method, att_id, transform, kDracoMeshBitstreamVersion);
+    std::unique_ptr<PredictionSchemeEncoder<DataTypeT, TransformT>> ret;
+    if (encoder->options()->GetAttributeBool(
+            att_id, "approximate_multi_parallelogram_search", false)) {
+      ret = CreateMeshPredictionScheme<
+          MeshEncoder, PredictionSchemeEncoder<DataTypeT, TransformT>,
+          MeshPredictionSchemeGreedyEncoderFactory<DataTypeT>>(
+          mesh_encoder, method, att_id, transform, kDracoMeshBitstreamVersion);
+    } else {
+      ret = CreateMeshPredictionScheme<
+          MeshEncoder, PredictionSchemeEncoder<DataTypeT, TransformT>,
+          MeshPredictionSchemeEncoderFactory<DataTypeT>>(
+          mesh_encoder, method, att_id, transform, kDracoMeshBitstreamVersion);
+    }
     if (ret) {
       return ret;
     }
@@ -59,6 +59,20 @@ class PredictionSchemeEncodingTransform {
     }
   }
 
+  // Computes corrections of |num_entries| consecutive entries. The entries are
+  // processed from the last one, so |out_corr_vals| may alias
+  // |original_vals| when the prediction of each entry is taken from the
+  // preceding entries (e.g. delta coding).
+  inline void ComputeCorrections(const DataTypeT *original_vals,
+                                 const DataTypeT *predicted_vals,
+                                 int num_entries, CorrTypeT *out_corr_vals) {
+    for (int i = num_entries - 1; i >= 0; --i) {
+      const int offset = i * num_components_;
+      ComputeCorrection(original_vals + offset, predicted_vals + offset,
+                        out_corr_vals + offset);
+    }
+  }
+
   // Encode any transform specific data.
   bool EncodeTransformData(EncoderBuffer * /* buffer */) { return true; }
 
@@ -90,6 +90,18 @@ class PredictionSchemeNormalOctahedronCanonicalizedEncodingTransform
     out_corr_vals[1] = corr[1];
   }
 
+  // Computes corrections of |num_entries| consecutive entries. The entries are
+  // processed from the last one, so |out_corr_vals| may alias |orig_vals|
+  // when the prediction of each entry is taken from the preceding entries.
+  inline void ComputeCorrections(const DataType *orig_vals,
+                                 const DataType *pred_vals, int num_entries,
+                                 CorrType *out_corr_vals) const {
+    for (int i = num_entries - 1; i >= 0; --i) {
+      ComputeCorrection(orig_vals + 2 * i, pred_vals + 2 * i,
+                        out_corr_vals + 2 * i);
+    }
+  }
+
  private:
   Point2 ComputeCorrection(Point2 orig, Point2 pred) const {
     const Point2 t(this->center_value(), this->center_value());
@@ -16,6 +16,7 @@
 #define DRACO_COMPRESSION_ATTRIBUTES_PREDICTION_SCHEMES_PREDICTION_SCHEME_WRAP_ENCODING_TRANSFORM_H_
 
 #include "draco/compression/attributes/prediction_schemes/prediction_scheme_wrap_transform_base.h"
+#include "draco/core/bit_utils.h"
 #include "draco/core/encoder_buffer.h"
 
 namespace draco {
@@ -68,6 +69,34 @@ class PredictionSchemeWrapEncodingTransform
     }
   }
 
+  // Computes corrections of |num_entries| consecutive entries. The result is
+  // the same as calling ComputeCorrection() for each entry starting from the
+  // last one, so |out_corr_vals| may alias |original_vals| when the prediction
+  // of each entry is taken from the preceding entries (e.g. delta coding). The
+  // loop has no data dependent branches so that it can be vectorized.
+  inline void ComputeCorrections(const DataTypeT *original_vals,
+                                 const DataTypeT *predicted_vals,
+                                 int num_entries,
+                                 CorrTypeT *out_corr_vals) const {
+    for (int i = num_entries * this->num_components() - 1; i >= 0; --i) {
+      out_corr_vals[i] = this->WrapCorrection(
+          original_vals[i] - this->ClampValue(predicted_vals[i]));
+    }
+  }
+
+  // Same as ComputeCorrections() followed by ConvertSignedIntsToSymbols(), but
+  // the symbols for the entropy coder are produced in a single pass over the
+  // data.
+  inline void ComputeCorrectionSymbols(const DataTypeT *original_vals,
+                                       const DataTypeT *predicted_vals,
+                                       int num_entries,
+                                       uint32_t *out_symbols) const {
+    for (int i = num_entries * this->num_components() - 1; i >= 0; --i) {
+      out_symbols[i] = ConvertSignedIntToSymbolBranchless(this->WrapCorrection(
+          original_vals[i] - this->ClampValue(predicted_vals[i])));
+    }
+  }
+
   bool EncodeTransformData(EncoderBuffer *buffer) {
     // Store the input value range as it is needed by the decoder.
     buffer->Encode(this->min_value());
@@ -73,6 +73,13 @@ class PredictionSchemeWrapTransformBase {
     return &clamped_value_[0];
   }
 
+  // Clamps a single value to the range of the original values. Same as
+  // ClampPredictedValue() but without branches.
+  inline DataTypeT ClampValue(DataTypeT val) const {
+    const DataTypeT clamped = val > max_value_ ? max_value_ : val;
+    return clamped < min_value_ ? min_value_ : clamped;
+  }
+
   // TODO(hemmer): Consider refactoring to avoid this dummy.
   int quantization_bits() const {
     DRACO_DCHECK(false);
@@ -95,6 +102,13 @@ class PredictionSchemeWrapTransformBase {
     return true;
   }
 
+  // Wraps a single correction value |corr| around the range of the original
+  // values.
+  inline DataTypeT WrapCorrection(DataTypeT corr) const {
+    return corr + (corr < min_correction_ ? max_dif_ : 0) -
+           (corr > max_correction_ ? max_dif_ : 0);
+  }
+
   inline int num_components() const { return num_components_; }
   inline DataTypeT min_value() const { return min_value_; }
   inline void set_min_value(const DataTypeT &v) { min_value_ = v; }
@@ -0,0 +1,125 @@
+// Copyright 2020 The Draco Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// File provides classes for block-wise adaptive rANS bit decoding.
+#ifndef DRACO_COMPRESSION_BIT_CODERS_ADAPTIVE_RANS_BLOCK_BIT_DECODER_H_
+#define DRACO_COMPRESSION_BIT_CODERS_ADAPTIVE_RANS_BLOCK_BIT_DECODER_H_
+
+#include <vector>
+
+#include "draco/compression/bit_coders/adaptive_rans_bit_coding_shared.h"
+#include "draco/compression/bit_coders/adaptive_rans_block_bit_encoder.h"
+#include "draco/compression/entropy/ans.h"
+#include "draco/core/decoder_buffer.h"
+#include "draco/core/varint_decoding.h"
+
+namespace draco {
+
+// Class for decoding a sequence of bits that were encoded with
+// AdaptiveRAnsBlockBitEncoder.
+class AdaptiveRAnsBlockBitDecoder {
+ public:
+  AdaptiveRAnsBlockBitDecoder()
+      : p0_f_(0.5), next_block_(0), num_block_bits_left_(0) {}
+
+  // Sets |source_buffer| as the buffer to decode bits from. The buffer is
+  // advanced past all encoded blocks.
+  bool StartDecoding(DecoderBuffer *source_buffer) {
+    Clear();
+    uint32_t num_blocks;
+    if (!DecodeVarint(&num_blocks, source_buffer)) {
+      return false;
+    }
+    for (uint32_t i = 0; i < num_blocks; ++i) {
+      uint32_t size_in_bytes;
+      if (!DecodeVarint(&size_in_bytes, source_buffer)) {
+        return false;
+      }
+      if (size_in_bytes > source_buffer->remaining_size()) {
+        return false;
+      }
+      blocks_.push_back(Block(
+          reinterpret_cast<const uint8_t *>(source_buffer->data_head()),
+          size_in_bytes));
+      source_buffer->Advance(size_in_bytes);
+    }
+    return true;
+  }
+
+  // Decode one bit. Returns true if the bit is a 1, otherwise false.
+  bool DecodeNextBit() {
+    if (num_block_bits_left_ == 0 && !StartNextBlock()) {
+      return false;
+    }
+    const uint8_t p0 = clamp_probability(p0_f_);
+    const bool bit = static_cast<bool>(rabs_read(&ans_decoder_, p0));
+    p0_f_ = update_probability(p0_f_, bit);
+    num_block_bits_left_--;
+    return bit;
+  }
+
+  // Decode the next |nbits| and return the sequence in |value|. |nbits| must be
+  // > 0 and <= 32.
+  void DecodeLeastSignificantBits32(int nbits, uint32_t *value) {
+    DRACO_DCHECK_EQ(true, nbits <= 32);
+    DRACO_DCHECK_EQ(true, nbits > 0);
+    uint32_t result = 0;
+    while (nbits) {
+      result = (result << 1) + DecodeNextBit();
+      --nbits;
+    }
+    *value = result;
+  }
+
+  void EndDecoding() {}
+
+ private:
+  struct Block {
+    Block(const uint8_t *d, uint32_t s) : data(d), size(s) {}
+    const uint8_t *data;
+    uint32_t size;
+  };
+
+  // Initializes the rANS decoder for the next block. Returns false when there
+  // are no more blocks or when the block is invalid.
+  bool StartNextBlock() {
+    if (next_block_ >= blocks_.size()) {
+      return false;
+    }
+    const Block &block = blocks_[next_block_++];
+    if (ans_read_init(&ans_decoder_, block.data,
+                      static_cast<int>(block.size)) != 0) {
+      return false;
+    }
+    num_block_bits_left_ = kAdaptiveRAnsBlockBits;
+    return true;
+  }
+
+  void Clear() {
+    p0_f_ = 0.5;
+    blocks_.clear();
+    next_block_ = 0;
+    num_block_bits_left_ = 0;
+  }
+
+  AnsDecoder ans_decoder_;
+  double p0_f_;
+  std::vector<Block> blocks_;
+  size_t next_block_;
+  int num_block_bits_left_;
+};
+
+}  // namespace draco
+
+#endif  // DRACO_COMPRESSION_BIT_CODERS_ADAPTIVE_RANS_BLOCK_BIT_DECODER_H_
@@ -0,0 +1,124 @@
+// Copyright 2020 The Draco Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// File provides classes for block-wise adaptive rANS bit encoding.
+#ifndef DRACO_COMPRESSION_BIT_CODERS_ADAPTIVE_RANS_BLOCK_BIT_ENCODER_H_
+#define DRACO_COMPRESSION_BIT_CODERS_ADAPTIVE_RANS_BLOCK_BIT_ENCODER_H_
+
+#include <vector>
+
+#include "draco/compression/bit_coders/adaptive_rans_bit_coding_shared.h"
+#include "draco/compression/entropy/ans.h"
+#include "draco/core/encoder_buffer.h"
+#include "draco/core/varint_encoding.h"
+
+namespace draco {
+
+// Number of bits coded by one rANS stream of the AdaptiveRAnsBlockBitEncoder.
+static constexpr int kAdaptiveRAnsBlockBits = 1 << 14;
+
+// Class for adaptive encoding a sequence of bits using rANS. It uses the same
+// adaptive probability model as AdaptiveRAnsBitEncoder, but instead of
+// buffering all input bits until EndEncoding(), the bits are coded in blocks
+// of kAdaptiveRAnsBlockBits as soon as a block is full. The memory needed for
+// the uncoded bits is therefore bounded by the block size. The probability
+// model is carried over between the blocks.
+// The encoded data must be decoded with AdaptiveRAnsBlockBitDecoder.
+class AdaptiveRAnsBlockBitEncoder {
+ public:
+  AdaptiveRAnsBlockBitEncoder()
+      : p0_f_(0.5), num_block_bits_(0), num_blocks_(0) {}
+
+  // Must be called before any Encode* function is called.
+  void StartEncoding() {
+    Clear();
+    block_bits_.resize(kAdaptiveRAnsBlockBits / 32);
+    block_probabilities_.resize(kAdaptiveRAnsBlockBits);
+    ans_buffer_.resize(kAdaptiveRAnsBlockBits + 16);
+  }
+
+  // Encode one bit. If |bit| is true encode a 1, otherwise encode a 0.
+  void EncodeBit(bool bit) {
+    // The probabilities are those of the forward sequence, but the bits are
+    // coded in the reverse order. Store the probability used for each bit.
+    block_probabilities_[num_block_bits_] = clamp_probability(p0_f_);
+    p0_f_ = update_probability(p0_f_, bit);
+    uint32_t &word = block_bits_[num_block_bits_ >> 5];
+    const uint32_t mask = 1u << (num_block_bits_ & 31);
+    word = bit ? (word | mask) : (word & ~mask);
+    if (++num_block_bits_ == kAdaptiveRAnsBlockBits) {
+      EncodeBlock();
+    }
+  }
+
+  // Encode |nbits| of |value|, starting from the least significant bit.
+  // |nbits| must be > 0 and <= 32.
+  void EncodeLeastSignificantBits32(int nbits, uint32_t value) {
+    DRACO_DCHECK_EQ(true, nbits <= 32);
+    DRACO_DCHECK_EQ(true, nbits > 0);
+    uint32_t selector = (1 << (nbits - 1));
+    while (selector) {
+      EncodeBit(value & selector);
+      selector = selector >> 1;
+    }
+  }
+
+  // Ends the bit encoding and stores the result into the target_buffer.
+  void EndEncoding(EncoderBuffer *target_buffer) {
+    if (num_block_bits_ > 0) {
+      EncodeBlock();
+    }
+    EncodeVarint(num_blocks_, target_buffer);
+    target_buffer->Encode(blocks_buffer_.data(), blocks_buffer_.size());
+    Clear();
+  }
+
+ private:
+  // Codes the currently buffered bits into a new block in |blocks_buffer_|.
+  void EncodeBlock() {
+    AnsCoder ans_coder;
+    ans_write_init(&ans_coder, ans_buffer_.data());
+    for (int i = num_block_bits_ - 1; i >= 0; --i) {
+      const int bit = (block_bits_[i >> 5] >> (i & 31)) & 1;
+      rabs_write(&ans_coder, bit, block_probabilities_[i]);
+    }
+    const uint32_t size_in_bytes = ans_write_end(&ans_coder);
+    EncodeVarint(size_in_bytes, &blocks_buffer_);
+    blocks_buffer_.Encode(ans_buffer_.data(), size_in_bytes);
+    num_block_bits_ = 0;
+    num_blocks_++;
+  }
+
+  void Clear() {
+    p0_f_ = 0.5;
+    num_block_bits_ = 0;
+    num_blocks_ = 0;
+    blocks_buffer_.Clear();
+  }
+
+  double p0_f_;
+  // Bits and their probabilities of the block that is currently being filled.
+  std::vector<uint32_t> block_bits_;
+  std::vector<uint8_t> block_probabilities_;
+  int num_block_bits_;
+  // Scratch buffer for the rANS coder.
+  std::vector<uint8_t> ans_buffer_;
+  // Already encoded blocks.
+  EncoderBuffer blocks_buffer_;
+  uint32_t num_blocks_;
+};
+
+}  // namespace draco
+
+#endif  // DRACO_COMPRESSION_BIT_CODERS_ADAPTIVE_RANS_BLOCK_BIT_ENCODER_H_
@@ -54,6 +54,12 @@ enum PointCloudEncodingMethod {
 enum MeshEncoderMethod {
   MESH_SEQUENTIAL_ENCODING = 0,
   MESH_EDGEBREAKER_ENCODING,
+  // Byte-oriented coding for live streaming where the encoding and decoding
+  // speed matters more than the compressed size (see mesh_realtime_coding.h).
+  MESH_REALTIME_ENCODING,
+  // Independent sub-streams of connected components that can be encoded and
+  // decoded in parallel (see mesh_components_coding.h).
+  MESH_COMPONENTS_ENCODING,
 };
 
 // List of various attribute encoders supported by our framework. The entries
@@ -141,6 +147,14 @@ enum NormalPredictionMode {
 enum SymbolCodingMethod {
   SYMBOL_CODING_TAGGED = 0,
   SYMBOL_CODING_RAW = 1,
+  // Same as SYMBOL_CODING_RAW but the symbols are coded with interleaved rANS
+  // states (see RAnsInterleavedEncoder in ans.h) for faster decoding. Only
+  // supported by EncodeSymbolsExtended() and DecodeSymbolsExtended().
+  SYMBOL_CODING_INTERLEAVED_RAW = 2,
+  // Symbols are split into independent blocks with their own probability
+  // tables that can be coded in parallel (see symbol_block_coding.h). Only
+  // supported by EncodeSymbolsExtended() and DecodeSymbolsExtended().
+  SYMBOL_CODING_BLOCKED_RAW = 3,
   NUM_SYMBOL_CODING_METHODS,
 };
 
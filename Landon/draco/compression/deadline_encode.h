@@ -0,0 +1,291 @@
+// Copyright 2020 The Draco Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DRACO_COMPRESSION_DEADLINE_ENCODE_H_
+#define DRACO_COMPRESSION_DEADLINE_ENCODE_H_
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "draco/compression/encode.h"
+#include "draco/compression/mesh/mesh_components_coding.h"
+#include "draco/core/encoder_buffer.h"
+#include "draco/core/status.h"
+#include "draco/mesh/mesh.h"
+
+namespace draco {
+
+// Encoding speeds considered by the DeadlineEncoder. The speed selects the
+// connectivity method, traversal, prediction schemes and entropy coding
+// settings used by the encoder (see Encoder::SetSpeedOptions()).
+static constexpr int kNumDeadlineEncodingSpeeds = 11;
+
+// Maximum number of vertices used for sampling the valence distribution.
+static constexpr int kMaxValenceSamples = 1 << 12;
+
+// Mesh properties that drive the cost of encoding.
+struct MeshEncodingStatistics {
+  MeshEncodingStatistics()
+      : num_faces(0),
+        num_vertices(0),
+        num_components(0),
+        num_attribute_values(0),
+        irregular_vertex_ratio(0.0) {}
+  int64_t num_faces;
+  // Number of position values used by the connectivity encoder.
+  int64_t num_vertices;
+  // Number of connected components (see ComputeMeshComponents()).
+  int64_t num_components;
+  // Total number of attribute value components over all attributes.
+  int64_t num_attribute_values;
+  // Ratio of sampled vertices whose valence differs from 6. Irregular vertices
+  // make the edgebreaker valence contexts less predictable.
+  double irregular_vertex_ratio;
+};
+
+// Computes MeshEncodingStatistics of |mesh|. The valence distribution is
+// sampled on at most kMaxValenceSamples vertices.
+inline MeshEncodingStatistics ComputeMeshEncodingStatistics(const Mesh &mesh) {
+  MeshEncodingStatistics stats;
+  stats.num_faces = mesh.num_faces();
+  for (int i = 0; i < mesh.num_attributes(); ++i) {
+    const PointAttribute *const att = mesh.attribute(i);
+    stats.num_attribute_values +=
+        static_cast<int64_t>(att->size()) * att->num_components();
+  }
+  std::vector<int> face_components;
+  stats.num_components = ComputeMeshComponents(mesh, &face_components);
+
+  const PointAttribute *const pos_att =
+      mesh.GetNamedAttribute(GeometryAttribute::POSITION);
+  stats.num_vertices = pos_att != nullptr ? pos_att->size() : mesh.num_points();
+  if (stats.num_vertices == 0) {
+    return stats;
+  }
+  // Valence of a vertex is approximated by the number of its incident faces,
+  // which is exact for vertices that are not on a boundary.
+  std::vector<int> valences(stats.num_vertices, 0);
+  for (FaceIndex f(0); f < mesh.num_faces(); ++f) {
+    for (int c = 0; c < 3; ++c) {
+      const PointIndex p = mesh.face(f)[c];
+      ++valences[pos_att != nullptr ? pos_att->mapped_index(p).value()
+                                    : p.value()];
+    }
+  }
+  const int64_t step =
+      std::max<int64_t>(1, stats.num_vertices / kMaxValenceSamples);
+  int64_t num_samples = 0;
+  int64_t num_irregular = 0;
+  for (int64_t v = 0; v < stats.num_vertices; v += step) {
+    ++num_samples;
+    num_irregular += valences[v] != 6;
+  }
+  stats.irregular_vertex_ratio =
+      static_cast<double>(num_irregular) / num_samples;
+  return stats;
+}
+
+// Linear model of the encoding time for each encoding speed. The time is
+// estimated as
+//
+//   fixed + face_cost * num_faces * topology_factor +
+//   value_cost * num_attribute_values
+//
+// where the topology factor grows with the number of connected components and
+// irregular vertices for speeds that use the edgebreaker. The default
+// coefficients are rough estimates for a recent desktop CPU. Calibrate() fits
+// the coefficients of each speed to the actual encoder and hardware, while
+// Update() tracks a scale shared by all speeds from the observed times.
+class EncodingCostModel {
+ public:
+  EncodingCostModel() : fixed_seconds_(1e-4), time_scale_(1.0) {
+    // Per face costs follow the methods the encoder selects for each speed:
+    // valence edgebreaker with constrained multi-parallelogram prediction at
+    // the slowest speeds, standard edgebreaker with parallelogram prediction
+    // in the middle and sequential coding at speed 10.
+    static constexpr double kFaceSeconds[kNumDeadlineEncodingSpeeds] = {
+        1.6e-6, 1.4e-6, 1.0e-6, 1.0e-6, 1.0e-6, 0.6e-6,
+        0.6e-6, 0.6e-6, 0.4e-6, 0.4e-6, 0.1e-6};
+    static constexpr double kValueSeconds[kNumDeadlineEncodingSpeeds] = {
+        6e-8, 6e-8, 4e-8, 4e-8, 4e-8, 3e-8, 3e-8, 3e-8, 2e-8, 2e-8, 1e-8};
+    for (int s = 0; s < kNumDeadlineEncodingSpeeds; ++s) {
+      face_seconds_[s] = kFaceSeconds[s];
+      value_seconds_[s] = kValueSeconds[s];
+    }
+  }
+
+  // Returns the estimated time of encoding a mesh with statistics |stats| at
+  // the given encoding |speed|.
+  double PredictSeconds(const MeshEncodingStatistics &stats, int speed) const {
+    return fixed_seconds_ +
+           time_scale_ * (face_seconds_[speed] * stats.num_faces *
+                              GetTopologyFactor(stats, speed) +
+                          value_seconds_[speed] * stats.num_attribute_values);
+  }
+
+  // Adjusts the model after an encoding at |speed| that took
+  // |actual_seconds|. The costs of all speeds are scaled towards the observed
+  // time with an exponential moving average so that a single outlier does not
+  // dominate the model.
+  void Update(const MeshEncodingStatistics &stats, int speed,
+              double actual_seconds) {
+    const double predicted_seconds = PredictSeconds(stats, speed);
+    if (predicted_seconds <= fixed_seconds_ ||
+        actual_seconds <= fixed_seconds_) {
+      return;
+    }
+    const double ratio = (actual_seconds - fixed_seconds_) /
+                         (predicted_seconds - fixed_seconds_);
+    time_scale_ *= 0.75 + 0.25 * ratio;
+  }
+
+  // Fits the model to |encoder| by encoding |mesh| at every speed. The costs
+  // of each speed are scaled so that the prediction matches the measured
+  // time. |mesh| should be representative of the meshes that are going to be
+  // encoded.
+  Status Calibrate(const Mesh &mesh, const Encoder &encoder) {
+    const MeshEncodingStatistics stats = ComputeMeshEncodingStatistics(mesh);
+    time_scale_ = 1.0;
+    for (int s = 0; s < kNumDeadlineEncodingSpeeds; ++s) {
+      Encoder speed_encoder = encoder;
+      speed_encoder.options().SetSpeed(s, s);
+      EncoderBuffer buffer;
+      const auto start_time = std::chrono::steady_clock::now();
+      DRACO_RETURN_IF_ERROR(speed_encoder.EncodeMeshToBuffer(mesh, &buffer));
+      const double actual_seconds =
+          std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                        start_time)
+              .count();
+      const double predicted_seconds = PredictSeconds(stats, s);
+      if (predicted_seconds > fixed_seconds_ &&
+          actual_seconds > fixed_seconds_) {
+        const double scale = (actual_seconds - fixed_seconds_) /
+                             (predicted_seconds - fixed_seconds_);
+        face_seconds_[s] *= scale;
+        value_seconds_[s] *= scale;
+      }
+    }
+    return OkStatus();
+  }
+
+ private:
+  static double GetTopologyFactor(const MeshEncodingStatistics &stats,
+                                  int speed) {
+    if (speed == 10 || stats.num_faces == 0) {
+      return 1.0;  // Sequential coding does not depend on the topology.
+    }
+    // Each component starts a new traversal and irregular vertices cost more
+    // in the valence coding used at speeds below 5.
+    const double irregular_weight = speed < 5 ? 0.5 : 0.2;
+    return 1.0 + 2.0 * stats.num_components / stats.num_faces +
+           irregular_weight * stats.irregular_vertex_ratio;
+  }
+
+  double fixed_seconds_;
+  // Scale applied to the costs of all speeds (see Update()).
+  double time_scale_;
+  double face_seconds_[kNumDeadlineEncodingSpeeds];
+  double value_seconds_[kNumDeadlineEncodingSpeeds];
+};
+
+// Result of the last encoding done by DeadlineEncoder.
+struct DeadlineEncodingReport {
+  DeadlineEncodingReport()
+      : encoding_speed(-1),
+        predicted_seconds(0.0),
+        actual_seconds(0.0),
+        statistics_seconds(0.0),
+        encoded_size(0) {}
+  int encoding_speed;
+  double predicted_seconds;
+  double actual_seconds;
+  // Time spent on computing MeshEncodingStatistics.
+  double statistics_seconds;
+  size_t encoded_size;
+};
+
+// Encoder that selects the encoding speed for each mesh so that the encoding
+// fits into a time budget. The slowest speed (i.e., the best compression)
+// whose predicted time fits into the budget is used. When no speed fits, the
+// fastest speed is used. All other options, including an explicitly set
+// decoding speed, are taken from the encoder passed to the constructor. The
+// cost model is updated with the measured time after every encoding.
+class DeadlineEncoder {
+ public:
+  explicit DeadlineEncoder(const Encoder &encoder)
+      : encoder_(encoder), time_budget_seconds_(0.0) {}
+
+  void set_time_budget(double seconds) { time_budget_seconds_ = seconds; }
+  double time_budget() const { return time_budget_seconds_; }
+
+  EncodingCostModel &cost_model() { return cost_model_; }
+  const EncodingCostModel &cost_model() const { return cost_model_; }
+
+  // Returns the speed selected for a mesh with statistics |stats| and a time
+  // budget of |budget_seconds|.
+  int SelectEncodingSpeed(const MeshEncodingStatistics &stats,
+                          double budget_seconds) const {
+    for (int s = 0; s < kNumDeadlineEncodingSpeeds - 1; ++s) {
+      if (cost_model_.PredictSeconds(stats, s) <= budget_seconds) {
+        return s;
+      }
+    }
+    return kNumDeadlineEncodingSpeeds - 1;
+  }
+
+  Status EncodeMeshToBuffer(const Mesh &mesh, EncoderBuffer *out_buffer) {
+    const auto start_time = std::chrono::steady_clock::now();
+    const MeshEncodingStatistics stats = ComputeMeshEncodingStatistics(mesh);
+    const auto encode_start_time = std::chrono::steady_clock::now();
+    report_ = DeadlineEncodingReport();
+    report_.statistics_seconds =
+        std::chrono::duration<double>(encode_start_time - start_time).count();
+    // The time needed for the statistics is taken from the budget.
+    report_.encoding_speed = SelectEncodingSpeed(
+        stats, time_budget_seconds_ - report_.statistics_seconds);
+    report_.predicted_seconds =
+        cost_model_.PredictSeconds(stats, report_.encoding_speed);
+
+    // An explicitly set decoding speed of the original encoder is kept.
+    const int decoding_speed =
+        encoder_.options().GetGlobalInt("decoding_speed", -1);
+    Encoder speed_encoder = encoder_;
+    speed_encoder.options().SetSpeed(
+        report_.encoding_speed,
+        decoding_speed >= 0 ? decoding_speed : report_.encoding_speed);
+    const size_t start_size = out_buffer->size();
+    DRACO_RETURN_IF_ERROR(speed_encoder.EncodeMeshToBuffer(mesh, out_buffer));
+    report_.actual_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                      encode_start_time)
+            .count();
+    report_.encoded_size = out_buffer->size() - start_size;
+    cost_model_.Update(stats, report_.encoding_speed, report_.actual_seconds);
+    return OkStatus();
+  }
+
+  // Returns the report of the last call of EncodeMeshToBuffer().
+  const DeadlineEncodingReport &last_report() const { return report_; }
+
+ private:
+  Encoder encoder_;
+  double time_budget_seconds_;
+  EncodingCostModel cost_model_;
+  DeadlineEncodingReport report_;
+};
+
+}  // namespace draco
+
+#endif  // DRACO_COMPRESSION_DEADLINE_ENCODE_H_
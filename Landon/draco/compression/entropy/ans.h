@@ -18,6 +18,10 @@
 // See http://arxiv.org/abs/1311.2540v2 for more information on rANS.
 // This file is based off libvpx's ans.h.
 
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #define DRACO_ANS_DIVIDE_BY_MULTIPLY 1
@@ -351,6 +355,8 @@ class RAnsEncoder {
  public:
   RAnsEncoder() {}
 
+  static constexpr int num_states() { return 1; }
+
   // Provides the input buffer where the data is going to be stored.
   inline void write_init(uint8_t *const buf) {
     ans_.buf = buf;
@@ -517,6 +523,413 @@ class RAnsDecoder {
   AnsDecoder ans_;
 };
 
+// Number of bits used to index the slots of the RAnsDecodingTable.
+static constexpr int kRAnsDecodingTableSlotBits = 12;
+
+// Table used by the RAnsCompactDecoder and the RAnsInterleavedDecoder to find
+// the decoded symbol for a given remainder of the rANS state. Instead of
+// storing one entry for each of the 2^|rans_precision_bits| possible
+// remainders (up to 2^20) like the RAnsDecoder does, the remainders are
+// grouped into at most 2^kRAnsDecodingTableSlotBits slots. Each slot stores the
+// first symbol whose probability range overlaps the slot, and when a slot
+// spans more symbols the exact symbol is found by a binary search over the
+// cumulative probabilities. For most slots no search is needed. The table
+// stays small enough to fit into the L1 cache regardless of the precision.
+class RAnsDecodingTable {
+ public:
+  RAnsDecodingTable() : slot_shift_(0) {}
+
+  // Builds the table from the probabilities of |num_symbols| symbols.
+  // Returns false if the table couldn't be built (because of wrong input data).
+  inline bool Build(const uint32_t token_probs[], uint32_t num_symbols,
+                    int rans_precision_bits) {
+    const uint32_t rans_precision = 1u << rans_precision_bits;
+    probability_table_.resize(num_symbols);
+    uint32_t cum_prob = 0;
+    for (uint32_t i = 0; i < num_symbols; ++i) {
+      probability_table_[i].prob = token_probs[i];
+      probability_table_[i].cum_prob = cum_prob;
+      cum_prob += token_probs[i];
+      if (cum_prob > rans_precision) {
+        return false;
+      }
+    }
+    if (cum_prob != rans_precision) {
+      return false;
+    }
+    slot_shift_ = std::max(rans_precision_bits - kRAnsDecodingTableSlotBits, 0);
+    const uint32_t num_slots = rans_precision >> slot_shift_;
+    slot_table_.resize(num_slots + 1);
+    uint32_t symbol = 0;
+    for (uint32_t slot = 0; slot < num_slots; ++slot) {
+      const uint32_t rem = slot << slot_shift_;
+      while (symbol + 1 < num_symbols &&
+             probability_table_[symbol + 1].cum_prob <= rem) {
+        ++symbol;
+      }
+      slot_table_[slot] = symbol;
+    }
+    slot_table_[num_slots] = num_symbols - 1;
+    return true;
+  }
+
+  // Returns the symbol whose probability range contains |rem|.
+  inline uint32_t FindSymbol(uint32_t rem) const {
+    const uint32_t slot = rem >> slot_shift_;
+    uint32_t first = slot_table_[slot];
+    uint32_t last = slot_table_[slot + 1];
+    // Find the last symbol with cum_prob <= rem. Symbols with zero probability
+    // share the cum_prob with the following symbol and are never returned.
+    while (first < last) {
+      const uint32_t mid = (first + last + 1) >> 1;
+      if (probability_table_[mid].cum_prob <= rem) {
+        first = mid;
+      } else {
+        last = mid - 1;
+      }
+    }
+    return first;
+  }
+
+  inline const rans_sym &symbol(uint32_t symbol_id) const {
+    return probability_table_[symbol_id];
+  }
+
+ private:
+  int slot_shift_;
+  std::vector<uint32_t> slot_table_;
+  std::vector<rans_sym> probability_table_;
+};
+
+// Cache of RAnsDecodingTables that lets decoders of different streams share
+// one table when their probabilities are identical, so that each distinct
+// table is built only once. The cache can be used from multiple threads.
+class RAnsDecodingTableCache {
+ public:
+  RAnsDecodingTableCache() {}
+
+  // Returns the table for the given probabilities, building it if it was not
+  // requested before. Returns nullptr if the table couldn't be built.
+  inline std::shared_ptr<const RAnsDecodingTable> GetTable(
+      const uint32_t token_probs[], uint32_t num_symbols,
+      int rans_precision_bits) {
+    std::vector<uint32_t> key(num_symbols + 1);
+    key[0] = rans_precision_bits;
+    std::copy(token_probs, token_probs + num_symbols, key.begin() + 1);
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<const RAnsDecodingTable> &table = tables_[key];
+    if (table == nullptr) {
+      std::shared_ptr<RAnsDecodingTable> new_table(new RAnsDecodingTable());
+      if (!new_table->Build(token_probs, num_symbols, rans_precision_bits)) {
+        tables_.erase(key);
+        return nullptr;
+      }
+      table = std::move(new_table);
+    }
+    return table;
+  }
+
+  // Returns the number of distinct tables that were built.
+  inline int num_tables() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<int>(tables_.size());
+  }
+
+ private:
+  std::mutex mutex_;
+  // Tables indexed by the precision followed by the symbol probabilities.
+  std::map<std::vector<uint32_t>, std::shared_ptr<const RAnsDecodingTable>>
+      tables_;
+};
+
+// Builds the decoding table for |token_probs| into |out_table|, or gets it
+// from |cache| when it is not null.
+inline bool BuildRAnsDecodingTable(
+    const uint32_t token_probs[], uint32_t num_symbols,
+    int rans_precision_bits, RAnsDecodingTableCache *cache,
+    std::shared_ptr<const RAnsDecodingTable> *out_table) {
+  if (cache != nullptr) {
+    *out_table = cache->GetTable(token_probs, num_symbols, rans_precision_bits);
+    return *out_table != nullptr;
+  }
+  std::shared_ptr<RAnsDecodingTable> table(new RAnsDecodingTable());
+  if (!table->Build(token_probs, num_symbols, rans_precision_bits)) {
+    return false;
+  }
+  *out_table = std::move(table);
+  return true;
+}
+
+// Class decoding the same data as the RAnsDecoder, but using the compact
+// RAnsDecodingTable instead of a lookup table with one entry per remainder.
+// Decoding tables can be shared between decoders through a
+// RAnsDecodingTableCache (see set_table_cache()).
+template <int rans_precision_bits_t>
+class RAnsCompactDecoder {
+ public:
+  RAnsCompactDecoder() : table_cache_(nullptr) {}
+
+  // Sets the cache used to get the decoding tables. Must be called before
+  // rans_build_look_up_table(). The cache must outlive the decoder.
+  void set_table_cache(RAnsDecodingTableCache *cache) { table_cache_ = cache; }
+
+  // Initializes the decoder from the input buffer. The |offset| specifies the
+  // number of bytes encoded by the encoder. A non zero return value is an
+  // error.
+  inline int read_init(const uint8_t *const buf, int offset) {
+    unsigned x;
+    if (offset < 1) {
+      return 1;
+    }
+    ans_.buf = buf;
+    x = buf[offset - 1] >> 6;
+    if (x == 0) {
+      ans_.buf_offset = offset - 1;
+      ans_.state = buf[offset - 1] & 0x3F;
+    } else if (x == 1) {
+      if (offset < 2) {
+        return 1;
+      }
+      ans_.buf_offset = offset - 2;
+      ans_.state = mem_get_le16(buf + offset - 2) & 0x3FFF;
+    } else if (x == 2) {
+      if (offset < 3) {
+        return 1;
+      }
+      ans_.buf_offset = offset - 3;
+      ans_.state = mem_get_le24(buf + offset - 3) & 0x3FFFFF;
+    } else if (x == 3) {
+      ans_.buf_offset = offset - 4;
+      ans_.state = mem_get_le32(buf + offset - 4) & 0x3FFFFFFF;
+    } else {
+      return 1;
+    }
+    ans_.state += l_rans_base;
+    if (ans_.state >= l_rans_base * DRACO_ANS_IO_BASE) {
+      return 1;
+    }
+    return 0;
+  }
+
+  inline int read_end() { return ans_.state == l_rans_base; }
+
+  inline int reader_has_error() {
+    return ans_.state < l_rans_base && ans_.buf_offset == 0;
+  }
+
+  inline int rans_read() {
+    while (ans_.state < l_rans_base && ans_.buf_offset > 0) {
+      ans_.state = ans_.state * DRACO_ANS_IO_BASE + ans_.buf[--ans_.buf_offset];
+    }
+    const uint32_t quo = ans_.state / rans_precision;
+    const uint32_t rem = ans_.state % rans_precision;
+    const uint32_t symbol = table_->FindSymbol(rem);
+    const rans_sym &sym = table_->symbol(symbol);
+    ans_.state = quo * sym.prob + rem - sym.cum_prob;
+    return symbol;
+  }
+
+  // Construct the decoding table for the given symbol probabilities.
+  // Returns false if the table couldn't be built (because of wrong input data).
+  inline bool rans_build_look_up_table(const uint32_t token_probs[],
+                                       uint32_t num_symbols) {
+    return BuildRAnsDecodingTable(token_probs, num_symbols,
+                                  rans_precision_bits_t, table_cache_,
+                                  &table_);
+  }
+
+ private:
+  static constexpr int rans_precision = 1 << rans_precision_bits_t;
+  static constexpr int l_rans_base = rans_precision * 4;
+  RAnsDecodingTableCache *table_cache_;
+  std::shared_ptr<const RAnsDecodingTable> table_;
+  AnsDecoder ans_;
+};
+
+// Number of rANS states used by RAnsInterleavedEncoder and
+// RAnsInterleavedDecoder. Four 32-bit states fill one 128-bit SIMD register.
+static constexpr int kRAnsNumInterleavedStates = 4;
+
+// Class for performing rANS encoding with multiple interleaved states (see
+// http://arxiv.org/abs/1402.3392). Consecutive symbols are coded with
+// different states so that the decoder can process them independently of each
+// other. All states share one output buffer. The symbol probabilities and the
+// precision are the same as with the RAnsEncoder, but the encoded data is not
+// compatible with it.
+template <int rans_precision_bits_t>
+class RAnsInterleavedEncoder {
+ public:
+  RAnsInterleavedEncoder() : buf_(nullptr), buf_offset_(0), state_id_(0) {}
+
+  static constexpr int num_states() { return kRAnsNumInterleavedStates; }
+
+  // Provides the input buffer where the data is going to be stored.
+  inline void write_init(uint8_t *const buf) {
+    buf_ = buf;
+    buf_offset_ = 0;
+    state_id_ = 0;
+    for (int i = 0; i < kRAnsNumInterleavedStates; ++i) {
+      states_[i] = l_rans_base;
+    }
+  }
+
+  // Needs to be called after all symbols are encoded. The states are stored in
+  // an order where the last used state (which encoded the first symbol of the
+  // input) is read first by the decoder.
+  inline int write_end() {
+    const int last_state_id =
+        (state_id_ + kRAnsNumInterleavedStates - 1) % kRAnsNumInterleavedStates;
+    for (int i = kRAnsNumInterleavedStates - 1; i >= 0; --i) {
+      const int state_id = (last_state_id - i + kRAnsNumInterleavedStates) %
+                           kRAnsNumInterleavedStates;
+      DRACO_DCHECK_GE(states_[state_id], l_rans_base);
+      DRACO_DCHECK_LT(states_[state_id], l_rans_base * DRACO_ANS_IO_BASE);
+      mem_put_le32(buf_ + buf_offset_, states_[state_id]);
+      buf_offset_ += 4;
+    }
+    return buf_offset_;
+  }
+
+  // rANS with normalization using the next state in the round robin order.
+  inline void rans_write(const struct rans_sym *const sym) {
+    uint32_t state = states_[state_id_];
+    const uint32_t p = sym->prob;
+    while (state >= l_rans_base / rans_precision * DRACO_ANS_IO_BASE * p) {
+      buf_[buf_offset_++] = state % DRACO_ANS_IO_BASE;
+      state /= DRACO_ANS_IO_BASE;
+    }
+    states_[state_id_] =
+        (state / p) * rans_precision + state % p + sym->cum_prob;
+    if (++state_id_ == kRAnsNumInterleavedStates) {
+      state_id_ = 0;
+    }
+  }
+
+ private:
+  static constexpr int rans_precision = 1 << rans_precision_bits_t;
+  static constexpr int l_rans_base = rans_precision * 4;
+  uint8_t *buf_;
+  int buf_offset_;
+  int state_id_;
+  uint32_t states_[kRAnsNumInterleavedStates];
+};
+
+// Class for decoding data encoded by the RAnsInterleavedEncoder. Unlike the
+// RAnsDecoder, the states are renormalized right after each decoded symbol so
+// that the input bytes are consumed in the exact reverse order in which the
+// encoder produced them.
+template <int rans_precision_bits_t>
+class RAnsInterleavedDecoder {
+ public:
+  RAnsInterleavedDecoder()
+      : table_cache_(nullptr), buf_(nullptr), buf_offset_(0), state_id_(0) {}
+
+  static constexpr int num_states() { return kRAnsNumInterleavedStates; }
+
+  // Sets the cache used to get the decoding tables. Must be called before
+  // rans_build_look_up_table(). The cache must outlive the decoder.
+  void set_table_cache(RAnsDecodingTableCache *cache) { table_cache_ = cache; }
+
+  // Initializes the decoder from the input buffer. The |offset| specifies the
+  // number of bytes encoded by the encoder. A non zero return value is an
+  // error.
+  inline int read_init(const uint8_t *const buf, int offset) {
+    if (offset < 4 * kRAnsNumInterleavedStates) {
+      return 1;
+    }
+    buf_ = buf;
+    buf_offset_ = offset;
+    state_id_ = 0;
+    for (int i = 0; i < kRAnsNumInterleavedStates; ++i) {
+      buf_offset_ -= 4;
+      states_[i] = mem_get_le32(buf_ + buf_offset_);
+      if (states_[i] < l_rans_base ||
+          states_[i] >= l_rans_base * DRACO_ANS_IO_BASE) {
+        return 1;
+      }
+    }
+    return 0;
+  }
+
+  inline int read_end() {
+    for (int i = 0; i < kRAnsNumInterleavedStates; ++i) {
+      if (states_[i] != l_rans_base) {
+        return 0;
+      }
+    }
+    return buf_offset_ == 0;
+  }
+
+  inline int rans_read() {
+    uint32_t state = states_[state_id_];
+    const uint32_t rem = state % rans_precision;
+    const uint32_t symbol = table_->FindSymbol(rem);
+    const rans_sym &sym = table_->symbol(symbol);
+    state = (state / rans_precision) * sym.prob + rem - sym.cum_prob;
+    while (state < l_rans_base && buf_offset_ > 0) {
+      state = state * DRACO_ANS_IO_BASE + buf_[--buf_offset_];
+    }
+    states_[state_id_] = state;
+    if (++state_id_ == kRAnsNumInterleavedStates) {
+      state_id_ = 0;
+    }
+    return symbol;
+  }
+
+  // Decodes |num_symbols| symbols into |out_symbols|. Whenever all states are
+  // aligned, one symbol is decoded with each state at once. The decoding of
+  // these symbols is independent and the compiler can map it on SIMD lanes;
+  // only the renormalization has to consume the input in the state order.
+  inline void rans_read_symbols(int num_symbols, uint32_t *out_symbols) {
+    const RAnsDecodingTable &table = *table_;
+    int i = 0;
+    while (i < num_symbols && state_id_ != 0) {
+      out_symbols[i++] = rans_read();
+    }
+    for (; i + kRAnsNumInterleavedStates <= num_symbols;
+         i += kRAnsNumInterleavedStates) {
+      uint32_t *const symbols = out_symbols + i;
+      uint32_t rem[kRAnsNumInterleavedStates];
+      for (int j = 0; j < kRAnsNumInterleavedStates; ++j) {
+        rem[j] = states_[j] % rans_precision;
+        symbols[j] = table.FindSymbol(rem[j]);
+      }
+      for (int j = 0; j < kRAnsNumInterleavedStates; ++j) {
+        const rans_sym &sym = table.symbol(symbols[j]);
+        states_[j] =
+            (states_[j] / rans_precision) * sym.prob + rem[j] - sym.cum_prob;
+      }
+      for (int j = 0; j < kRAnsNumInterleavedStates; ++j) {
+        while (states_[j] < l_rans_base && buf_offset_ > 0) {
+          states_[j] = states_[j] * DRACO_ANS_IO_BASE + buf_[--buf_offset_];
+        }
+      }
+    }
+    while (i < num_symbols) {
+      out_symbols[i++] = rans_read();
+    }
+  }
+
+  // Construct the decoding table for the given symbol probabilities.
+  // Returns false if the table couldn't be built (because of wrong input data).
+  inline bool rans_build_look_up_table(const uint32_t token_probs[],
+                                       uint32_t num_symbols) {
+    return BuildRAnsDecodingTable(token_probs, num_symbols,
+                                  rans_precision_bits_t, table_cache_,
+                                  &table_);
+  }
+
+ private:
+  static constexpr int rans_precision = 1 << rans_precision_bits_t;
+  static constexpr int l_rans_base = rans_precision * 4;
+  RAnsDecodingTableCache *table_cache_;
+  std::shared_ptr<const RAnsDecodingTable> table_;
+  const uint8_t *buf_;
+  int buf_offset_;
+  int state_id_;
+  uint32_t states_[kRAnsNumInterleavedStates];
+};
+
 #undef DRACO_ANS_DIVREM
 #undef DRACO_ANS_P8_PRECISION
 #undef DRACO_ANS_L_BASE
@@ -0,0 +1,310 @@
+// Copyright 2020 The Draco Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// File providing entry points for symbol coding that also handle the
+// SymbolCodingMethod values that are not supported by EncodeSymbols() and
+// DecodeSymbols(). Streams using the other methods are forwarded to these
+// functions, so the entry points can be used in place of them.
+#ifndef DRACO_COMPRESSION_ENTROPY_EXTENDED_SYMBOL_CODING_H_
+#define DRACO_COMPRESSION_ENTROPY_EXTENDED_SYMBOL_CODING_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "draco/compression/config/compression_shared.h"
+#include "draco/compression/entropy/rans_symbol_decoder.h"
+#include "draco/compression/entropy/rans_symbol_encoder.h"
+#include "draco/compression/entropy/symbol_block_coding.h"
+#include "draco/compression/entropy/symbol_decoding.h"
+#include "draco/compression/entropy/symbol_encoding.h"
+#include "draco/compression/entropy/symbol_histogram.h"
+#include "draco/core/bit_utils.h"
+#include "draco/core/decoder_buffer.h"
+#include "draco/core/encoder_buffer.h"
+#include "draco/core/options.h"
+
+namespace draco {
+
+// Maximum bit length of unique symbols supported by the interleaved raw
+// coding. Same as the limit of the raw symbol coding.
+static constexpr int kMaxInterleavedRawSymbolBitLength = 18;
+
+template <int unique_symbols_bit_length_t>
+bool EncodeInterleavedRawSymbolsInternal(
+    const uint32_t *symbols, int num_values,
+    const std::vector<uint64_t> &frequencies, EncoderBuffer *target_buffer) {
+  RAnsInterleavedSymbolEncoder<unique_symbols_bit_length_t> encoder;
+  if (!encoder.Create(frequencies.data(), static_cast<int>(frequencies.size()),
+                      target_buffer)) {
+    return false;
+  }
+  encoder.StartEncoding(target_buffer);
+  // Symbols are encoded in the reverse order so that the decoder can output
+  // them in the original order.
+  for (int i = num_values - 1; i >= 0; --i) {
+    encoder.EncodeSymbol(symbols[i]);
+  }
+  encoder.EndEncoding(target_buffer);
+  return true;
+}
+
+// Encodes |num_values| symbols with interleaved rANS states. The probability
+// table and the precision are selected in the same way as by the raw symbol
+// coding, including the "symbol_encoding_compression_level" option.
+inline bool EncodeInterleavedRawSymbols(const uint32_t *symbols,
+                                        int num_values, const Options *options,
+                                        EncoderBuffer *target_buffer) {
+  std::vector<uint64_t> frequencies;
+  const ShannonEntropyTracker::EntropyData entropy_data =
+      ComputeSymbolHistogram(symbols, num_values, 1, &frequencies);
+  int unique_symbols_bit_length =
+      MostSignificantBit(entropy_data.num_unique_symbols) + 1;
+  // Compression level is used to adjust the precision of the probabilities.
+  if (options != nullptr &&
+      options->IsOptionSet("symbol_encoding_compression_level")) {
+    const int compression_level =
+        options->GetInt("symbol_encoding_compression_level");
+    if (compression_level < 4) {
+      unique_symbols_bit_length -= 2;
+    } else if (compression_level < 6) {
+      unique_symbols_bit_length -= 1;
+    } else if (compression_level > 9) {
+      unique_symbols_bit_length += 2;
+    } else if (compression_level > 7) {
+      unique_symbols_bit_length += 1;
+    }
+  }
+  unique_symbols_bit_length =
+      std::min(std::max(1, unique_symbols_bit_length),
+               kMaxInterleavedRawSymbolBitLength);
+  target_buffer->Encode(static_cast<uint8_t>(unique_symbols_bit_length));
+  switch (unique_symbols_bit_length) {
+    case 1:
+      return EncodeInterleavedRawSymbolsInternal<1>(
+          symbols, num_values, frequencies, target_buffer);
+    case 2:
+      return EncodeInterleavedRawSymbolsInternal<2>(
+          symbols, num_values, frequencies, target_buffer);
+    case 3:
+      return EncodeInterleavedRawSymbolsInternal<3>(
+          symbols, num_values, frequencies, target_buffer);
+    case 4:
+      return EncodeInterleavedRawSymbolsInternal<4>(
+          symbols, num_values, frequencies, target_buffer);
+    case 5:
+      return EncodeInterleavedRawSymbolsInternal<5>(
+          symbols, num_values, frequencies, target_buffer);
+    case 6:
+      return EncodeInterleavedRawSymbolsInternal<6>(
+          symbols, num_values, frequencies, target_buffer);
+    case 7:
+      return EncodeInterleavedRawSymbolsInternal<7>(
+          symbols, num_values, frequencies, target_buffer);
+    case 8:
+      return EncodeInterleavedRawSymbolsInternal<8>(
+          symbols, num_values, frequencies, target_buffer);
+    case 9:
+      return EncodeInterleavedRawSymbolsInternal<9>(
+          symbols, num_values, frequencies, target_buffer);
+    case 10:
+      return EncodeInterleavedRawSymbolsInternal<10>(
+          symbols, num_values, frequencies, target_buffer);
+    case 11:
+      return EncodeInterleavedRawSymbolsInternal<11>(
+          symbols, num_values, frequencies, target_buffer);
+    case 12:
+      return EncodeInterleavedRawSymbolsInternal<12>(
+          symbols, num_values, frequencies, target_buffer);
+    case 13:
+      return EncodeInterleavedRawSymbolsInternal<13>(
+          symbols, num_values, frequencies, target_buffer);
+    case 14:
+      return EncodeInterleavedRawSymbolsInternal<14>(
+          symbols, num_values, frequencies, target_buffer);
+    case 15:
+      return EncodeInterleavedRawSymbolsInternal<15>(
+          symbols, num_values, frequencies, target_buffer);
+    case 16:
+      return EncodeInterleavedRawSymbolsInternal<16>(
+          symbols, num_values, frequencies, target_buffer);
+    case 17:
+      return EncodeInterleavedRawSymbolsInternal<17>(
+          symbols, num_values, frequencies, target_buffer);
+    case 18:
+      return EncodeInterleavedRawSymbolsInternal<18>(
+          symbols, num_values, frequencies, target_buffer);
+    default:
+      return false;
+  }
+}
+
+template <int unique_symbols_bit_length_t>
+bool DecodeInterleavedRawSymbolsInternal(uint32_t num_values,
+                                         DecoderBuffer *src_buffer,
+                                         uint32_t *out_values) {
+  RAnsInterleavedSymbolDecoder<unique_symbols_bit_length_t> decoder;
+  if (!decoder.Create(src_buffer)) {
+    return false;
+  }
+  if (num_values > 0 && decoder.num_symbols() == 0) {
+    return false;  // Wrong number of symbols.
+  }
+  if (!decoder.StartDecoding(src_buffer)) {
+    return false;
+  }
+  decoder.DecodeSymbols(static_cast<int>(num_values), out_values);
+  decoder.EndDecoding();
+  return true;
+}
+
+// Decodes |num_values| symbols encoded by EncodeInterleavedRawSymbols() into
+// |out_values|. Returns false on error.
+inline bool DecodeInterleavedRawSymbols(uint32_t num_values,
+                                        DecoderBuffer *src_buffer,
+                                        uint32_t *out_values) {
+  uint8_t unique_symbols_bit_length;
+  if (!src_buffer->Decode(&unique_symbols_bit_length)) {
+    return false;
+  }
+  switch (unique_symbols_bit_length) {
+    case 1:
+      return DecodeInterleavedRawSymbolsInternal<1>(num_values, src_buffer,
+                                                      out_values);
+    case 2:
+      return DecodeInterleavedRawSymbolsInternal<2>(num_values, src_buffer,
+                                                      out_values);
+    case 3:
+      return DecodeInterleavedRawSymbolsInternal<3>(num_values, src_buffer,
+                                                      out_values);
+    case 4:
+      return DecodeInterleavedRawSymbolsInternal<4>(num_values, src_buffer,
+                                                      out_values);
+    case 5:
+      return DecodeInterleavedRawSymbolsInternal<5>(num_values, src_buffer,
+                                                      out_values);
+    case 6:
+      return DecodeInterleavedRawSymbolsInternal<6>(num_values, src_buffer,
+                                                      out_values);
+    case 7:
+      return DecodeInterleavedRawSymbolsInternal<7>(num_values, src_buffer,
+                                                      out_values);
+    case 8:
+      return DecodeInterleavedRawSymbolsInternal<8>(num_values, src_buffer,
+                                                      out_values);
+    case 9:
+      return DecodeInterleavedRawSymbolsInternal<9>(num_values, src_buffer,
+                                                      out_values);
+    case 10:
+      return DecodeInterleavedRawSymbolsInternal<10>(num_values, src_buffer,
+                                                      out_values);
+    case 11:
+      return DecodeInterleavedRawSymbolsInternal<11>(num_values, src_buffer,
+                                                      out_values);
+    case 12:
+      return DecodeInterleavedRawSymbolsInternal<12>(num_values, src_buffer,
+                                                      out_values);
+    case 13:
+      return DecodeInterleavedRawSymbolsInternal<13>(num_values, src_buffer,
+                                                      out_values);
+    case 14:
+      return DecodeInterleavedRawSymbolsInternal<14>(num_values, src_buffer,
+                                                      out_values);
+    case 15:
+      return DecodeInterleavedRawSymbolsInternal<15>(num_values, src_buffer,
+                                                      out_values);
+    case 16:
+      return DecodeInterleavedRawSymbolsInternal<16>(num_values, src_buffer,
+                                                      out_values);
+    case 17:
+      return DecodeInterleavedRawSymbolsInternal<17>(num_values, src_buffer,
+                                                      out_values);
+    case 18:
+      return DecodeInterleavedRawSymbolsInternal<18>(num_values, src_buffer,
+                                                      out_values);
+    default:
+      return false;
+  }
+}
+
+// Same as EncodeSymbols() but it also supports the SymbolCodingMethod values
+// that are not handled by EncodeSymbols(). The method is selected with
+// SetSymbolEncodingMethod() in |options|. Other methods are encoded by
+// EncodeSymbols(). SYMBOL_CODING_BLOCKED_RAW uses up to
+// "symbol_encoding_num_threads" threads (1 by default). The encoded data
+// does not depend on the number of threads. Returns false on error.
+inline bool EncodeSymbolsExtended(const uint32_t *symbols, int num_values,
+                                  int num_components, const Options *options,
+                                  EncoderBuffer *target_buffer) {
+  if (num_values < 0) {
+    return false;
+  }
+  if (num_values == 0) {
+    return true;
+  }
+  const int method =
+      options == nullptr ? -1 : options->GetInt("symbol_encoding_method", -1);
+  switch (method) {
+    case SYMBOL_CODING_INTERLEAVED_RAW:
+      target_buffer->Encode(static_cast<uint8_t>(method));
+      return EncodeInterleavedRawSymbols(symbols, num_values, options,
+                                         target_buffer);
+    case SYMBOL_CODING_BLOCKED_RAW:
+      target_buffer->Encode(static_cast<uint8_t>(method));
+      return EncodeSymbolsInBlocks(
+          symbols, num_values,
+          options->GetInt("symbol_encoding_num_threads", 1), target_buffer);
+    default:
+      return EncodeSymbols(symbols, num_values, num_components, options,
+                           target_buffer);
+  }
+}
+
+// Decodes symbols encoded by EncodeSymbolsExtended(). Symbols coded with
+// SYMBOL_CODING_BLOCKED_RAW are decoded on up to |num_threads| threads.
+// Returns false on error.
+inline bool DecodeSymbolsExtended(uint32_t num_values, int num_components,
+                                  int num_threads, DecoderBuffer *src_buffer,
+                                  uint32_t *out_values) {
+  if (num_values == 0) {
+    return true;
+  }
+  // The method is only peeked because DecodeSymbols() decodes it again.
+  uint8_t method;
+  if (!src_buffer->Peek(&method)) {
+    return false;
+  }
+  switch (method) {
+    case SYMBOL_CODING_INTERLEAVED_RAW:
+      src_buffer->Advance(1);
+      return DecodeInterleavedRawSymbols(num_values, src_buffer, out_values);
+    case SYMBOL_CODING_BLOCKED_RAW:
+      src_buffer->Advance(1);
+      return DecodeSymbolsInBlocks(num_values, num_threads, src_buffer,
+                                   out_values);
+    default:
+      return DecodeSymbols(num_values, num_components, src_buffer, out_values);
+  }
+}
+
+// Same as above but all symbols are decoded on the calling thread.
+inline bool DecodeSymbolsExtended(uint32_t num_values, int num_components,
+                                  DecoderBuffer *src_buffer,
+                                  uint32_t *out_values) {
+  return DecodeSymbolsExtended(num_values, num_components, 1, src_buffer,
+                               out_values);
+}
+
+}  // namespace draco
+
+#endif  // DRACO_COMPRESSION_ENTROPY_EXTENDED_SYMBOL_CODING_H_
@@ -26,11 +26,12 @@ namespace draco {
 // A helper class for decoding symbols using the rANS algorithm (see ans.h).
 // The class can be used to decode the probability table and the data encoded
 // by the RAnsSymbolEncoder. |unique_symbols_bit_length_t| must be the same as
-// the one used for the corresponding RAnsSymbolEncoder.
-template <int unique_symbols_bit_length_t>
-class RAnsSymbolDecoder {
+// the one used for the corresponding RAnsSymbolEncoder. |RAnsDecoderT| must
+// match the rANS coder used by the encoder.
+template <int unique_symbols_bit_length_t, template <int> class RAnsDecoderT>
+class RAnsSymbolDecoderBase {
  public:
-  RAnsSymbolDecoder() : num_symbols_(0) {}
+  RAnsSymbolDecoderBase() : num_symbols_(0) {}
 
   // Initialize the decoder and decode the probability table.
   bool Create(DecoderBuffer *buffer);
@@ -43,19 +44,62 @@ class RAnsSymbolDecoder {
   uint32_t DecodeSymbol() { return ans_.rans_read(); }
   void EndDecoding();
 
- private:
+ protected:
   static constexpr int rans_precision_bits_ =
       ComputeRAnsPrecisionFromUniqueSymbolsBitLength(
           unique_symbols_bit_length_t);
   static constexpr int rans_precision_ = 1 << rans_precision_bits_;
 
+  RAnsDecoderT<rans_precision_bits_> *ans() { return &ans_; }
+
+ private:
   std::vector<uint32_t> probability_table_;
   uint32_t num_symbols_;
-  RAnsDecoder<rans_precision_bits_> ans_;
+  RAnsDecoderT<rans_precision_bits_> ans_;
+};
+
+// Symbol decoder for data encoded by RAnsSymbolEncoder.
+template <int unique_symbols_bit_length_t>
+class RAnsSymbolDecoder
+    : public RAnsSymbolDecoderBase<unique_symbols_bit_length_t, RAnsDecoder> {
+};
+
+// Symbol decoder for data encoded by RAnsSymbolEncoder that uses the compact
+// decoding tables of the RAnsCompactDecoder.
+template <int unique_symbols_bit_length_t>
+class RAnsCompactSymbolDecoder
+    : public RAnsSymbolDecoderBase<unique_symbols_bit_length_t,
+                                   RAnsCompactDecoder> {
+ public:
+  // Sets the cache that is used to share the decoding tables with other
+  // decoders. Must be called before Create().
+  void set_table_cache(RAnsDecodingTableCache *cache) {
+    this->ans()->set_table_cache(cache);
+  }
 };
 
+// Symbol decoder for data encoded by RAnsInterleavedSymbolEncoder.
 template <int unique_symbols_bit_length_t>
-bool RAnsSymbolDecoder<unique_symbols_bit_length_t>::Create(
+class RAnsInterleavedSymbolDecoder
+    : public RAnsSymbolDecoderBase<unique_symbols_bit_length_t,
+                                   RAnsInterleavedDecoder> {
+ public:
+  // Sets the cache that is used to share the decoding tables with other
+  // decoders. Must be called before Create().
+  void set_table_cache(RAnsDecodingTableCache *cache) {
+    this->ans()->set_table_cache(cache);
+  }
+
+  // Decodes |num_symbols| symbols into |out_symbols|, decoding one symbol per
+  // interleaved state at a time.
+  void DecodeSymbols(int num_symbols, uint32_t *out_symbols) {
+    this->ans()->rans_read_symbols(num_symbols, out_symbols);
+  }
+};
+
+template <int unique_symbols_bit_length_t, template <int> class RAnsDecoderT>
+bool RAnsSymbolDecoderBase<unique_symbols_bit_length_t,
+                           RAnsDecoderT>::Create(
     DecoderBuffer *buffer) {
   // Check that the DecoderBuffer version is set.
   if (buffer->bitstream_version() == 0) {
@@ -123,8 +167,9 @@ bool RAnsSymbolDecoder<unique_symbols_bit_length_t>::Create(
   return true;
 }
 
-template <int unique_symbols_bit_length_t>
-bool RAnsSymbolDecoder<unique_symbols_bit_length_t>::StartDecoding(
+template <int unique_symbols_bit_length_t, template <int> class RAnsDecoderT>
+bool RAnsSymbolDecoderBase<unique_symbols_bit_length_t,
+                           RAnsDecoderT>::StartDecoding(
     DecoderBuffer *buffer) {
   uint64_t bytes_encoded;
   // Decode the number of bytes encoded by the encoder.
@@ -154,8 +199,9 @@ bool RAnsSymbolDecoder<unique_symbols_bit_length_t>::StartDecoding(
   return true;
 }
 
-template <int unique_symbols_bit_length_t>
-void RAnsSymbolDecoder<unique_symbols_bit_length_t>::EndDecoding() {
+template <int unique_symbols_bit_length_t, template <int> class RAnsDecoderT>
+void RAnsSymbolDecoderBase<unique_symbols_bit_length_t,
+                           RAnsDecoderT>::EndDecoding() {
   ans_.read_end();
 }
 
@@ -29,10 +29,12 @@ namespace draco {
 // A helper class for encoding symbols using the rANS algorithm (see ans.h).
 // The class can be used to initialize and encode probability table needed by
 // rANS, and to perform encoding of symbols into the provided EncoderBuffer.
-template <int unique_symbols_bit_length_t>
-class RAnsSymbolEncoder {
+// |RAnsEncoderT| is the rANS coder used to encode the symbols. The format of
+// the probability table does not depend on it.
+template <int unique_symbols_bit_length_t, template <int> class RAnsEncoderT>
+class RAnsSymbolEncoderBase {
  public:
-  RAnsSymbolEncoder()
+  RAnsSymbolEncoderBase()
       : num_symbols_(0), num_expected_bits_(0), buffer_offset_(0) {}
 
   // Creates a probability table needed by the rANS library and encode it into
@@ -78,13 +80,27 @@ class RAnsSymbolEncoder {
   // Expected number of bits that is needed to encode the input.
   uint64_t num_expected_bits_;
 
-  RAnsEncoder<rans_precision_bits_> ans_;
+  RAnsEncoderT<rans_precision_bits_> ans_;
   // Initial offset of the encoder buffer before any ans data was encoded.
   uint64_t buffer_offset_;
 };
 
+// Symbol encoder using a single rANS state.
+template <int unique_symbols_bit_length_t>
+class RAnsSymbolEncoder
+    : public RAnsSymbolEncoderBase<unique_symbols_bit_length_t, RAnsEncoder> {
+};
+
+// Symbol encoder using interleaved rANS states (see RAnsInterleavedEncoder).
+// The encoded data must be decoded with RAnsInterleavedSymbolDecoder.
 template <int unique_symbols_bit_length_t>
-bool RAnsSymbolEncoder<unique_symbols_bit_length_t>::Create(
+class RAnsInterleavedSymbolEncoder
+    : public RAnsSymbolEncoderBase<unique_symbols_bit_length_t,
+                                   RAnsInterleavedEncoder> {};
+
+template <int unique_symbols_bit_length_t, template <int> class RAnsEncoderT>
+bool RAnsSymbolEncoderBase<unique_symbols_bit_length_t,
+                           RAnsEncoderT>::Create(
     const uint64_t *frequencies, int num_symbols, EncoderBuffer *buffer) {
   // Compute the total of the input frequencies.
   uint64_t total_freq = 0;
@@ -202,8 +218,9 @@ bool RAnsSymbolEncoder<unique_symbols_bit_length_t>::Create(
   return true;
 }
 
-template <int unique_symbols_bit_length_t>
-bool RAnsSymbolEncoder<unique_symbols_bit_length_t>::EncodeTable(
+template <int unique_symbols_bit_length_t, template <int> class RAnsEncoderT>
+bool RAnsSymbolEncoderBase<unique_symbols_bit_length_t,
+                           RAnsEncoderT>::EncodeTable(
     EncoderBuffer *buffer) {
   EncodeVarint(num_symbols_, buffer);
   // Use varint encoding for the probabilities (first two bits represent the
@@ -250,11 +267,15 @@ bool RAnsSymbolEncoder<unique_symbols_bit_length_t>::EncodeTable(
   return true;
 }
 
-template <int unique_symbols_bit_length_t>
-void RAnsSymbolEncoder<unique_symbols_bit_length_t>::StartEncoding(
+template <int unique_symbols_bit_length_t, template <int> class RAnsEncoderT>
+void RAnsSymbolEncoderBase<unique_symbols_bit_length_t,
+                           RAnsEncoderT>::StartEncoding(
     EncoderBuffer *buffer) {
-  // Allocate extra storage just in case.
-  const uint64_t required_bits = 2 * num_expected_bits_ + 32;
+  // Allocate extra storage just in case (including the final state of each
+  // rANS state).
+  const uint64_t required_bits =
+      2 * num_expected_bits_ +
+      32 * RAnsEncoderT<rans_precision_bits_>::num_states();
 
   buffer_offset_ = buffer->size();
   const int64_t required_bytes = (required_bits + 7) / 8;
@@ -264,8 +285,9 @@ void RAnsSymbolEncoder<unique_symbols_bit_length_t>::StartEncoding(
   ans_.write_init(data + buffer_offset_);
 }
 
-template <int unique_symbols_bit_length_t>
-void RAnsSymbolEncoder<unique_symbols_bit_length_t>::EndEncoding(
+template <int unique_symbols_bit_length_t, template <int> class RAnsEncoderT>
+void RAnsSymbolEncoderBase<unique_symbols_bit_length_t,
+                           RAnsEncoderT>::EndEncoding(
     EncoderBuffer *buffer) {
   char *const src = const_cast<char *>(buffer->data()) + buffer_offset_;
 
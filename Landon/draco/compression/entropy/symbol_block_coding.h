@@ -0,0 +1,336 @@
+// Copyright 2020 The Draco Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// File providing functions for entropy coding of symbols in independent blocks
+// that can be encoded and decoded in parallel.
+#ifndef DRACO_COMPRESSION_ENTROPY_SYMBOL_BLOCK_CODING_H_
+#define DRACO_COMPRESSION_ENTROPY_SYMBOL_BLOCK_CODING_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "draco/compression/entropy/rans_symbol_decoder.h"
+#include "draco/compression/entropy/rans_symbol_encoder.h"
+#include "draco/compression/entropy/symbol_histogram.h"
+#include "draco/core/bit_utils.h"
+#include "draco/core/decoder_buffer.h"
+#include "draco/core/encoder_buffer.h"
+#include "draco/core/parallel_for.h"
+#include "draco/core/varint_decoding.h"
+#include "draco/core/varint_encoding.h"
+
+namespace draco {
+
+// Number of symbols coded in one block by EncodeSymbolsInBlocks().
+static constexpr int kSymbolCodingBlockSize = 1 << 16;
+
+// Maximum bit length of unique symbols supported by the block coding. Same as
+// the limit of the raw symbol coding.
+static constexpr int kMaxBlockSymbolBitLength = 18;
+
+template <int unique_symbols_bit_length_t>
+bool EncodeSymbolBlockInternal(const uint32_t *symbols, int num_values,
+                               const std::vector<uint64_t> &frequencies,
+                               EncoderBuffer *target_buffer) {
+  RAnsSymbolEncoder<unique_symbols_bit_length_t> encoder;
+  if (!encoder.Create(frequencies.data(), static_cast<int>(frequencies.size()),
+                      target_buffer)) {
+    return false;
+  }
+  encoder.StartEncoding(target_buffer);
+  for (int i = num_values - 1; i >= 0; --i) {
+    encoder.EncodeSymbol(symbols[i]);
+  }
+  encoder.EndEncoding(target_buffer);
+  return true;
+}
+
+// Encodes one block of symbols together with its own probability table.
+inline bool EncodeSymbolBlock(const uint32_t *symbols, int num_values,
+                              EncoderBuffer *target_buffer) {
+  std::vector<uint64_t> frequencies;
+  const ShannonEntropyTracker::EntropyData entropy_data =
+      ComputeSymbolHistogram(symbols, num_values, 1, &frequencies);
+  const int unique_symbols_bit_length =
+      MostSignificantBit(std::max(entropy_data.num_unique_symbols, 1)) + 1;
+  if (unique_symbols_bit_length > kMaxBlockSymbolBitLength) {
+    return false;
+  }
+  target_buffer->Encode(static_cast<uint8_t>(unique_symbols_bit_length));
+  switch (unique_symbols_bit_length) {
+    case 1:
+      return EncodeSymbolBlockInternal<1>(symbols, num_values, frequencies,
+                                          target_buffer);
+    case 2:
+      return EncodeSymbolBlockInternal<2>(symbols, num_values, frequencies,
+                                          target_buffer);
+    case 3:
+      return EncodeSymbolBlockInternal<3>(symbols, num_values, frequencies,
+                                          target_buffer);
+    case 4:
+      return EncodeSymbolBlockInternal<4>(symbols, num_values, frequencies,
+                                          target_buffer);
+    case 5:
+      return EncodeSymbolBlockInternal<5>(symbols, num_values, frequencies,
+                                          target_buffer);
+    case 6:
+      return EncodeSymbolBlockInternal<6>(symbols, num_values, frequencies,
+                                          target_buffer);
+    case 7:
+      return EncodeSymbolBlockInternal<7>(symbols, num_values, frequencies,
+                                          target_buffer);
+    case 8:
+      return EncodeSymbolBlockInternal<8>(symbols, num_values, frequencies,
+                                          target_buffer);
+    case 9:
+      return EncodeSymbolBlockInternal<9>(symbols, num_values, frequencies,
+                                          target_buffer);
+    case 10:
+      return EncodeSymbolBlockInternal<10>(symbols, num_values, frequencies,
+                                           target_buffer);
+    case 11:
+      return EncodeSymbolBlockInternal<11>(symbols, num_values, frequencies,
+                                           target_buffer);
+    case 12:
+      return EncodeSymbolBlockInternal<12>(symbols, num_values, frequencies,
+                                           target_buffer);
+    case 13:
+      return EncodeSymbolBlockInternal<13>(symbols, num_values, frequencies,
+                                           target_buffer);
+    case 14:
+      return EncodeSymbolBlockInternal<14>(symbols, num_values, frequencies,
+                                           target_buffer);
+    case 15:
+      return EncodeSymbolBlockInternal<15>(symbols, num_values, frequencies,
+                                           target_buffer);
+    case 16:
+      return EncodeSymbolBlockInternal<16>(symbols, num_values, frequencies,
+                                           target_buffer);
+    case 17:
+      return EncodeSymbolBlockInternal<17>(symbols, num_values, frequencies,
+                                           target_buffer);
+    case 18:
+      return EncodeSymbolBlockInternal<18>(symbols, num_values, frequencies,
+                                           target_buffer);
+    default:
+      return false;
+  }
+}
+
+template <int unique_symbols_bit_length_t>
+bool DecodeSymbolBlockInternal(int num_values, DecoderBuffer *src_buffer,
+                               RAnsDecodingTableCache *table_cache,
+                               uint32_t *out_values) {
+  RAnsCompactSymbolDecoder<unique_symbols_bit_length_t> decoder;
+  decoder.set_table_cache(table_cache);
+  if (!decoder.Create(src_buffer)) {
+    return false;
+  }
+  if (num_values > 0 && decoder.num_symbols() == 0) {
+    return false;  // Wrong number of symbols.
+  }
+  if (!decoder.StartDecoding(src_buffer)) {
+    return false;
+  }
+  for (int i = 0; i < num_values; ++i) {
+    out_values[i] = decoder.DecodeSymbol();
+  }
+  decoder.EndDecoding();
+  return true;
+}
+
+// Decodes one block of symbols encoded by EncodeSymbolBlock(). Decoding tables
+// are shared through |table_cache| when it is not null.
+inline bool DecodeSymbolBlock(int num_values, DecoderBuffer *src_buffer,
+                              RAnsDecodingTableCache *table_cache,
+                              uint32_t *out_values) {
+  uint8_t unique_symbols_bit_length;
+  if (!src_buffer->Decode(&unique_symbols_bit_length)) {
+    return false;
+  }
+  switch (unique_symbols_bit_length) {
+    case 1:
+      return DecodeSymbolBlockInternal<1>(num_values, src_buffer,
+                                          table_cache, out_values);
+    case 2:
+      return DecodeSymbolBlockInternal<2>(num_values, src_buffer,
+                                          table_cache, out_values);
+    case 3:
+      return DecodeSymbolBlockInternal<3>(num_values, src_buffer,
+                                          table_cache, out_values);
+    case 4:
+      return DecodeSymbolBlockInternal<4>(num_values, src_buffer,
+                                          table_cache, out_values);
+    case 5:
+      return DecodeSymbolBlockInternal<5>(num_values, src_buffer,
+                                          table_cache, out_values);
+    case 6:
+      return DecodeSymbolBlockInternal<6>(num_values, src_buffer,
+                                          table_cache, out_values);
+    case 7:
+      return DecodeSymbolBlockInternal<7>(num_values, src_buffer,
+                                          table_cache, out_values);
+    case 8:
+      return DecodeSymbolBlockInternal<8>(num_values, src_buffer,
+                                          table_cache, out_values);
+    case 9:
+      return DecodeSymbolBlockInternal<9>(num_values, src_buffer,
+                                          table_cache, out_values);
+    case 10:
+      return DecodeSymbolBlockInternal<10>(num_values, src_buffer,
+                                           table_cache, out_values);
+    case 11:
+      return DecodeSymbolBlockInternal<11>(num_values, src_buffer,
+                                           table_cache, out_values);
+    case 12:
+      return DecodeSymbolBlockInternal<12>(num_values, src_buffer,
+                                           table_cache, out_values);
+    case 13:
+      return DecodeSymbolBlockInternal<13>(num_values, src_buffer,
+                                           table_cache, out_values);
+    case 14:
+      return DecodeSymbolBlockInternal<14>(num_values, src_buffer,
+                                           table_cache, out_values);
+    case 15:
+      return DecodeSymbolBlockInternal<15>(num_values, src_buffer,
+                                           table_cache, out_values);
+    case 16:
+      return DecodeSymbolBlockInternal<16>(num_values, src_buffer,
+                                           table_cache, out_values);
+    case 17:
+      return DecodeSymbolBlockInternal<17>(num_values, src_buffer,
+                                           table_cache, out_values);
+    case 18:
+      return DecodeSymbolBlockInternal<18>(num_values, src_buffer,
+                                           table_cache, out_values);
+    default:
+      return false;
+  }
+}
+
+// Encodes |num_values| symbols split into blocks of kSymbolCodingBlockSize
+// symbols. Each block has its own probability table and rANS state and the
+// blocks are encoded in parallel on up to |num_threads| threads. The byte size
+// of each block is stored in front of the block data so that the decoder can
+// locate all blocks up front. The output does not depend on |num_threads|.
+// Returns false on error.
+inline bool EncodeSymbolsInBlocks(const uint32_t *symbols, int num_values,
+                                  int num_threads,
+                                  EncoderBuffer *target_buffer) {
+  const int num_blocks =
+      (num_values + kSymbolCodingBlockSize - 1) / kSymbolCodingBlockSize;
+  std::vector<EncoderBuffer> block_buffers(num_blocks);
+  std::vector<uint8_t> block_encoded(num_blocks, 0);
+  ParallelFor(num_blocks, GetNumParallelChunks(num_blocks, num_threads, 1),
+              [&](int /* chunk_id */, int64_t begin, int64_t end) {
+                for (int64_t b = begin; b < end; ++b) {
+                  const int first_value =
+                      static_cast<int>(b) * kSymbolCodingBlockSize;
+                  const int num_block_values = std::min(
+                      kSymbolCodingBlockSize, num_values - first_value);
+                  block_encoded[b] =
+                      EncodeSymbolBlock(symbols + first_value, num_block_values,
+                                        &block_buffers[b]);
+                }
+              });
+  EncodeVarint(static_cast<uint32_t>(kSymbolCodingBlockSize), target_buffer);
+  for (int b = 0; b < num_blocks; ++b) {
+    if (!block_encoded[b]) {
+      return false;
+    }
+    EncodeVarint(static_cast<uint64_t>(block_buffers[b].size()),
+                 target_buffer);
+  }
+  for (int b = 0; b < num_blocks; ++b) {
+    target_buffer->Encode(block_buffers[b].data(), block_buffers[b].size());
+  }
+  return true;
+}
+
+// Decodes |num_values| symbols encoded by EncodeSymbolsInBlocks() into
+// |out_values|. The blocks are decoded in parallel on up to |num_threads|
+// threads. Blocks with identical probability tables share one decoding table
+// from |table_cache|. The cache can be reused when decoding more streams, for
+// example all components of an attribute. Returns false on error.
+inline bool DecodeSymbolsInBlocks(uint32_t num_values, int num_threads,
+                                  RAnsDecodingTableCache *table_cache,
+                                  DecoderBuffer *src_buffer,
+                                  uint32_t *out_values) {
+  uint32_t block_size;
+  if (!DecodeVarint(&block_size, src_buffer) || block_size == 0) {
+    return false;
+  }
+  const uint32_t num_blocks = static_cast<uint32_t>(
+      (static_cast<uint64_t>(num_values) + block_size - 1) / block_size);
+  // Each block stores at least one byte for its size.
+  if (num_blocks > src_buffer->remaining_size()) {
+    return false;
+  }
+  std::vector<uint64_t> block_offsets(num_blocks + 1, 0);
+  for (uint32_t b = 0; b < num_blocks; ++b) {
+    uint64_t block_bytes;
+    if (!DecodeVarint(&block_bytes, src_buffer)) {
+      return false;
+    }
+    const uint64_t remaining_size =
+        static_cast<uint64_t>(src_buffer->remaining_size());
+    if (block_offsets[b] > remaining_size ||
+        block_bytes > remaining_size - block_offsets[b]) {
+      return false;
+    }
+    block_offsets[b + 1] = block_offsets[b] + block_bytes;
+  }
+  if (block_offsets[num_blocks] >
+      static_cast<uint64_t>(src_buffer->remaining_size())) {
+    return false;
+  }
+  const char *const blocks_data = src_buffer->data_head();
+  src_buffer->Advance(block_offsets[num_blocks]);
+  std::vector<uint8_t> block_decoded(num_blocks, 0);
+  ParallelFor(num_blocks, GetNumParallelChunks(num_blocks, num_threads, 1),
+              [&](int /* chunk_id */, int64_t begin, int64_t end) {
+                for (int64_t b = begin; b < end; ++b) {
+                  DecoderBuffer block_buffer;
+                  block_buffer.Init(blocks_data + block_offsets[b],
+                                    block_offsets[b + 1] - block_offsets[b],
+                                    src_buffer->bitstream_version());
+                  const uint32_t first_value =
+                      static_cast<uint32_t>(b) * block_size;
+                  const uint32_t num_block_values =
+                      std::min(block_size, num_values - first_value);
+                  block_decoded[b] = DecodeSymbolBlock(
+                      num_block_values, &block_buffer, table_cache,
+                      out_values + first_value);
+                }
+              });
+  for (uint32_t b = 0; b < num_blocks; ++b) {
+    if (!block_decoded[b]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Same as above but the decoding tables are only shared within the stream.
+inline bool DecodeSymbolsInBlocks(uint32_t num_values, int num_threads,
+                                  DecoderBuffer *src_buffer,
+                                  uint32_t *out_values) {
+  RAnsDecodingTableCache table_cache;
+  return DecodeSymbolsInBlocks(num_values, num_threads, &table_cache,
+                               src_buffer, out_values);
+}
+
+}  // namespace draco
+
+#endif  // DRACO_COMPRESSION_ENTROPY_SYMBOL_BLOCK_CODING_H_
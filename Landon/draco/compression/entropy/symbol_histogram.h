@@ -0,0 +1,168 @@
+// Copyright 2020 The Draco Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DRACO_COMPRESSION_ENTROPY_SYMBOL_HISTOGRAM_H_
+#define DRACO_COMPRESSION_ENTROPY_SYMBOL_HISTOGRAM_H_
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "draco/compression/entropy/shannon_entropy.h"
+#include "draco/core/parallel_for.h"
+
+namespace draco {
+
+// Minimum number of symbols processed by one thread in ComputeSymbolHistogram.
+static constexpr int64_t kMinSymbolsPerHistogramThread = 1 << 18;
+
+// Maximum number of bins for which AccumulateSymbolHistogram() uses
+// sub-histograms. Larger sub-histograms would not fit into the L1 cache.
+static constexpr int kMaxSubHistogramBins = 1 << 12;
+
+// Number of symbols that AccumulateSymbolHistogram() processes at once. The
+// largest symbol of a tile is found before the tile is counted so that the
+// histogram can be grown up front. A tile stays in the L1 cache between the
+// two loops, so the input is read from memory only once.
+static constexpr int kSymbolHistogramTileSize = 1 << 10;
+
+// Adds the counts of the interleaved |sub_histograms| to |histogram|.
+inline void MergeSubHistograms(const std::vector<uint32_t> &sub_histograms,
+                               std::vector<uint64_t> *histogram) {
+  const size_t num_bins = sub_histograms.size() / 4;
+  for (size_t s = 0; s < num_bins; ++s) {
+    const uint32_t *const counts = &sub_histograms[4 * s];
+    (*histogram)[s] +=
+        static_cast<uint64_t>(counts[0]) + counts[1] + counts[2] + counts[3];
+  }
+}
+
+// Adds the frequencies of symbols in range [begin, end) to |histogram|. The
+// histogram is grown as needed to hold all symbols. Returns the largest
+// symbol in the range (0 for an empty range). While the symbols are small,
+// four independent sub-histograms are used so that repeated symbols do not
+// make consecutive increments wait on each other through the same memory
+// location.
+inline uint32_t AccumulateSymbolHistogram(const uint32_t *symbols,
+                                          int64_t begin, int64_t end,
+                                          std::vector<uint64_t> *histogram) {
+  // Sub-histograms only pay off when the input is large compared to the
+  // number of bins that need to be merged. The counter of sub-histogram k for
+  // symbol s is stored at index 4 * s + k.
+  bool use_sub_histograms = end - begin >= 4 * kMaxSubHistogramBins;
+  std::vector<uint32_t> sub_histograms;
+  uint32_t max_symbol = 0;
+  for (int64_t tile_begin = begin; tile_begin < end;
+       tile_begin += kSymbolHistogramTileSize) {
+    const int64_t tile_end =
+        std::min(tile_begin + kSymbolHistogramTileSize, end);
+    uint32_t tile_max_symbol = 0;
+    for (int64_t i = tile_begin; i < tile_end; ++i) {
+      tile_max_symbol = std::max(tile_max_symbol, symbols[i]);
+    }
+    if (tile_max_symbol >= histogram->size()) {
+      histogram->resize(static_cast<size_t>(tile_max_symbol) + 1, 0);
+    }
+    max_symbol = std::max(max_symbol, tile_max_symbol);
+    if (use_sub_histograms && max_symbol >= kMaxSubHistogramBins) {
+      // Symbols got too large, continue with the plain histogram.
+      MergeSubHistograms(sub_histograms, histogram);
+      use_sub_histograms = false;
+    }
+    if (!use_sub_histograms) {
+      for (int64_t i = tile_begin; i < tile_end; ++i) {
+        (*histogram)[symbols[i]]++;
+      }
+      continue;
+    }
+    if (4 * static_cast<size_t>(max_symbol) >= sub_histograms.size()) {
+      sub_histograms.resize(4 * (static_cast<size_t>(max_symbol) + 1), 0);
+    }
+    uint32_t *const h = sub_histograms.data();
+    int64_t i = tile_begin;
+    for (; i + 4 <= tile_end; i += 4) {
+      h[4 * symbols[i]]++;
+      h[4 * symbols[i + 1] + 1]++;
+      h[4 * symbols[i + 2] + 2]++;
+      h[4 * symbols[i + 3] + 3]++;
+    }
+    for (; i < tile_end; ++i) {
+      h[4 * symbols[i]]++;
+    }
+  }
+  if (use_sub_histograms) {
+    MergeSubHistograms(sub_histograms, histogram);
+  }
+  return max_symbol;
+}
+
+// Computes the frequencies of |num_symbols| symbols and stores them in
+// |out_frequencies|, which is resized to the largest symbol + 1 entries. The
+// largest symbol does not need to be known in advance: the input is read only
+// once and the histogram grows as larger symbols are found. Large inputs are
+// split between up to |num_threads| threads.
+// Returns the entropy data of the input in the same form as the
+// ShannonEntropyTracker, i.e. including the number of unique symbols and the
+// largest symbol. The number of bits needed to encode the symbols can be
+// obtained using ShannonEntropyTracker::GetNumberOfDataBits().
+inline ShannonEntropyTracker::EntropyData ComputeSymbolHistogram(
+    const uint32_t *symbols, int num_symbols, int num_threads,
+    std::vector<uint64_t> *out_frequencies) {
+  out_frequencies->assign(1, 0);
+  const int num_chunks = GetNumParallelChunks(num_symbols, num_threads,
+                                              kMinSymbolsPerHistogramThread);
+  uint32_t max_symbol = 0;
+  if (num_chunks == 1) {
+    max_symbol =
+        AccumulateSymbolHistogram(symbols, 0, num_symbols, out_frequencies);
+  } else {
+    std::vector<std::vector<uint64_t>> chunk_histograms(num_chunks);
+    std::vector<uint32_t> chunk_max_symbols(num_chunks, 0);
+    ParallelFor(num_symbols, num_chunks,
+                [&](int chunk_id, int64_t begin, int64_t end) {
+                  chunk_max_symbols[chunk_id] = AccumulateSymbolHistogram(
+                      symbols, begin, end, &chunk_histograms[chunk_id]);
+                });
+    for (int c = 0; c < num_chunks; ++c) {
+      max_symbol = std::max(max_symbol, chunk_max_symbols[c]);
+    }
+    out_frequencies->resize(static_cast<size_t>(max_symbol) + 1, 0);
+    for (int c = 0; c < num_chunks; ++c) {
+      const std::vector<uint64_t> &chunk_histogram = chunk_histograms[c];
+      for (size_t s = 0; s < chunk_histogram.size(); ++s) {
+        (*out_frequencies)[s] += chunk_histogram[s];
+      }
+    }
+  }
+
+  ShannonEntropyTracker::EntropyData entropy_data;
+  entropy_data.num_values = num_symbols;
+  entropy_data.max_symbol = static_cast<int>(max_symbol);
+  for (size_t s = 0; s < out_frequencies->size(); ++s) {
+    const uint64_t freq = (*out_frequencies)[s];
+    if (freq == 0) {
+      continue;
+    }
+    entropy_data.num_unique_symbols++;
+    const double freq_d = static_cast<double>(freq);
+    entropy_data.entropy_norm += freq_d * std::log2(freq_d);
+  }
+  return entropy_data;
+}
+
+}  // namespace draco
+
+#endif  // DRACO_COMPRESSION_ENTROPY_SYMBOL_HISTOGRAM_H_
@@ -0,0 +1,322 @@
+// Copyright 2020 The Draco Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// File providing functions for inspecting encoded Draco geometry without
+// decoding it, and for decoding meshes into existing Mesh instances so that
+// callers that decode many files can reuse their storage.
+#ifndef DRACO_COMPRESSION_GEOMETRY_INFO_H_
+#define DRACO_COMPRESSION_GEOMETRY_INFO_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "draco/attributes/geometry_attribute.h"
+#include "draco/compression/config/compression_shared.h"
+#include "draco/compression/decode.h"
+#include "draco/compression/mesh/mesh_realtime_coding.h"
+#include "draco/compression/point_cloud/point_cloud_decoder.h"
+#include "draco/core/decoder_buffer.h"
+#include "draco/core/draco_types.h"
+#include "draco/core/status.h"
+#include "draco/core/status_or.h"
+#include "draco/core/varint_decoding.h"
+#include "draco/mesh/mesh.h"
+
+namespace draco {
+
+// Description of an encoded attribute.
+struct GeometryAttributeInfo {
+  GeometryAttribute::Type attribute_type;
+  DataType data_type;
+  int num_components;
+  bool normalized;
+  uint32_t unique_id;
+  // Number of unique attribute values.
+  uint32_t num_values;
+  // False when points are mapped to attribute values through an explicit
+  // index map with one entry per point.
+  bool is_mapping_identity;
+  MeshAttributeElementType element_type;
+};
+
+// Information about encoded geometry returned by PeekGeometryInfo().
+struct GeometryInfo {
+  GeometryInfo()
+      : geometry_type(INVALID_GEOMETRY_TYPE),
+        encoding_method(0),
+        version_major(0),
+        version_minor(0),
+        has_metadata(false),
+        num_faces(0),
+        num_points(0),
+        is_num_points_exact(false),
+        has_attribute_info(false) {}
+
+  EncodedGeometryType geometry_type;
+  // One of PointCloudEncodingMethod or MeshEncoderMethod depending on the
+  // |geometry_type|.
+  int encoding_method;
+  uint8_t version_major;
+  uint8_t version_minor;
+  bool has_metadata;
+  // Number of faces. Always 0 for point clouds.
+  uint32_t num_faces;
+  // Number of points. When |is_num_points_exact| is false, the value is only a
+  // lower bound. This is the case for MESH_EDGEBREAKER_ENCODING where the
+  // stream stores the number of vertices and the points on attribute seams are
+  // created during decoding.
+  uint32_t num_points;
+  bool is_num_points_exact;
+  // True when |attributes| describes all encoded attributes. Attribute
+  // descriptions are stored after the connectivity, so they are only available
+  // for encodings that allow skipping the connectivity without decoding it
+  // (currently MESH_REALTIME_ENCODING).
+  bool has_attribute_info;
+  std::vector<GeometryAttributeInfo> attributes;
+};
+
+namespace {
+
+// Advances |in_buffer| past a name stored by the metadata encoder.
+inline bool SkipMetadataName(DecoderBuffer *in_buffer) {
+  uint8_t name_length;
+  if (!in_buffer->Decode(&name_length) ||
+      in_buffer->remaining_size() < name_length) {
+    return false;
+  }
+  in_buffer->Advance(name_length);
+  return true;
+}
+
+// Advances |in_buffer| past one metadata including all of its sub-metadata.
+// Sub-metadata are stored depth first right after the entries of their parent,
+// so it is enough to count the blocks that are left to be skipped.
+inline bool SkipMetadata(DecoderBuffer *in_buffer) {
+  uint64_t num_blocks = 1;
+  bool is_root = true;
+  while (num_blocks > 0) {
+    --num_blocks;
+    if (!is_root && !SkipMetadataName(in_buffer)) {
+      return false;
+    }
+    is_root = false;
+    uint32_t num_entries;
+    if (!DecodeVarint(&num_entries, in_buffer)) {
+      return false;
+    }
+    for (uint32_t i = 0; i < num_entries; ++i) {
+      uint32_t data_size;
+      if (!SkipMetadataName(in_buffer) ||
+          !DecodeVarint(&data_size, in_buffer) || data_size == 0 ||
+          in_buffer->remaining_size() < data_size) {
+        return false;
+      }
+      in_buffer->Advance(data_size);
+    }
+    uint32_t num_sub_metadata;
+    if (!DecodeVarint(&num_sub_metadata, in_buffer) ||
+        num_sub_metadata > in_buffer->remaining_size()) {
+      return false;
+    }
+    num_blocks += num_sub_metadata;
+  }
+  return true;
+}
+
+// Advances |in_buffer| past the geometry metadata (attribute metadata followed
+// by the metadata of the whole geometry).
+inline bool SkipGeometryMetadata(DecoderBuffer *in_buffer) {
+  uint32_t num_attribute_metadata;
+  if (!DecodeVarint(&num_attribute_metadata, in_buffer)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < num_attribute_metadata; ++i) {
+    uint32_t attribute_unique_id;
+    if (!DecodeVarint(&attribute_unique_id, in_buffer) ||
+        !SkipMetadata(in_buffer)) {
+      return false;
+    }
+  }
+  return SkipMetadata(in_buffer);
+}
+
+// Decodes a 32-bit count that is stored either as a raw value (bitstreams
+// older than |varint_version|) or as a varint.
+inline bool DecodeGeometryCount(uint16_t varint_version,
+                                DecoderBuffer *in_buffer, uint32_t *out_count) {
+  if (in_buffer->bitstream_version() < varint_version) {
+    return in_buffer->Decode(out_count);
+  }
+  return DecodeVarint(out_count, in_buffer);
+}
+
+// Fills the sizes and attribute descriptions of a MESH_REALTIME_ENCODING
+// stream. |in_buffer| must point at the start of the stream.
+inline Status PeekMeshRealtimeInfo(DecoderBuffer *in_buffer,
+                                   GeometryInfo *out_info) {
+  DRACO_RETURN_IF_ERROR(DecodeMeshRealtimeHeader(
+      in_buffer, &out_info->num_faces, &out_info->num_points));
+  out_info->is_num_points_exact = true;
+  if (!SkipVarints(3 * static_cast<int>(out_info->num_faces), in_buffer)) {
+    return Status(Status::IO_ERROR, "Failed to decode connectivity.");
+  }
+  uint8_t num_attributes;
+  if (!in_buffer->Decode(&num_attributes)) {
+    return Status(Status::IO_ERROR, "Failed to decode attributes.");
+  }
+  out_info->attributes.resize(num_attributes);
+  for (int i = 0; i < num_attributes; ++i) {
+    MeshRealtimeAttributeHeader header;
+    DRACO_RETURN_IF_ERROR(
+        DecodeMeshRealtimeAttributeHeader(in_buffer, &header));
+    DRACO_RETURN_IF_ERROR(
+        SkipMeshRealtimeAttributeData(header, out_info->num_points, in_buffer));
+    GeometryAttributeInfo &att_info = out_info->attributes[i];
+    att_info.attribute_type = header.attribute_type;
+    att_info.data_type = header.data_type;
+    att_info.num_components = header.num_components;
+    att_info.normalized = header.normalized;
+    att_info.unique_id = header.unique_id;
+    att_info.num_values = header.num_values;
+    att_info.is_mapping_identity = header.is_mapping_identity;
+    att_info.element_type = header.element_type;
+  }
+  out_info->has_attribute_info = true;
+  return OkStatus();
+}
+
+}  // namespace
+
+// Parses the headers of geometry encoded in |in_buffer| and returns its sizes
+// without decoding it. Only the Draco header, the metadata and the
+// connectivity header are read for all encoding methods, so the cost does not
+// depend on the size of the geometry. For MESH_REALTIME_ENCODING the data is
+// skipped to also read the attribute descriptions. The position of
+// |in_buffer| is not changed.
+inline StatusOr<GeometryInfo> PeekGeometryInfo(DecoderBuffer *in_buffer) {
+  DecoderBuffer buffer(*in_buffer);
+  DracoHeader header;
+  DRACO_RETURN_IF_ERROR(PointCloudDecoder::DecodeHeader(&buffer, &header));
+  GeometryInfo info;
+  info.geometry_type = static_cast<EncodedGeometryType>(header.encoder_type);
+  info.encoding_method = header.encoder_method;
+  info.version_major = header.version_major;
+  info.version_minor = header.version_minor;
+  info.has_metadata = (header.flags & METADATA_FLAG_MASK) != 0;
+  if (info.geometry_type == TRIANGULAR_MESH &&
+      info.encoding_method == MESH_REALTIME_ENCODING) {
+    // The realtime stream is parsed from its start by its own decoder.
+    DecoderBuffer realtime_buffer(*in_buffer);
+    DRACO_RETURN_IF_ERROR(PeekMeshRealtimeInfo(&realtime_buffer, &info));
+    return info;
+  }
+
+  const uint16_t version =
+      DRACO_BITSTREAM_VERSION(header.version_major, header.version_minor);
+  buffer.set_bitstream_version(version);
+  if (info.has_metadata && version >= DRACO_BITSTREAM_VERSION(1, 3) &&
+      !SkipGeometryMetadata(&buffer)) {
+    return Status(Status::IO_ERROR, "Failed to skip metadata.");
+  }
+  if (info.geometry_type == POINT_CLOUD) {
+    // Both point cloud encodings start with the number of points.
+    int32_t num_points;
+    if (info.encoding_method > POINT_CLOUD_KD_TREE_ENCODING ||
+        !buffer.Decode(&num_points) || num_points < 0) {
+      return Status(Status::DRACO_ERROR, "Failed to decode point cloud size.");
+    }
+    info.num_points = num_points;
+    info.is_num_points_exact = true;
+    return info;
+  }
+  if (info.geometry_type != TRIANGULAR_MESH) {
+    return Status(Status::DRACO_ERROR, "Unsupported geometry type.");
+  }
+  if (info.encoding_method == MESH_SEQUENTIAL_ENCODING) {
+    if (!DecodeGeometryCount(DRACO_BITSTREAM_VERSION(2, 2), &buffer,
+                             &info.num_faces) ||
+        !DecodeGeometryCount(DRACO_BITSTREAM_VERSION(2, 2), &buffer,
+                             &info.num_points)) {
+      return Status(Status::IO_ERROR, "Failed to decode mesh size.");
+    }
+    info.is_num_points_exact = true;
+    return info;
+  }
+  if (info.encoding_method == MESH_EDGEBREAKER_ENCODING) {
+    // Traversal decoder type followed by the connectivity header.
+    uint8_t traversal_decoder_type;
+    uint32_t num_new_vertices;
+    if (!buffer.Decode(&traversal_decoder_type) ||
+        (version < DRACO_BITSTREAM_VERSION(2, 2) &&
+         !buffer.Decode(&num_new_vertices)) ||
+        !DecodeGeometryCount(DRACO_BITSTREAM_VERSION(2, 0), &buffer,
+                             &info.num_points) ||
+        !DecodeGeometryCount(DRACO_BITSTREAM_VERSION(2, 0), &buffer,
+                             &info.num_faces)) {
+      return Status(Status::IO_ERROR, "Failed to decode mesh size.");
+    }
+    return info;
+  }
+  return Status(Status::DRACO_ERROR, "Unsupported encoding method.");
+}
+
+// Returns the number of bytes needed to store the decoded faces, attribute
+// values and point mappings of geometry described by |info|. The value is
+// exact when |info.has_attribute_info| and |info.is_num_points_exact| are set.
+// Otherwise it only accounts for the known parts and it is a lower bound.
+inline int64_t GetDecodedGeometrySize(const GeometryInfo &info) {
+  int64_t size = static_cast<int64_t>(info.num_faces) * sizeof(Mesh::Face);
+  for (const GeometryAttributeInfo &att_info : info.attributes) {
+    size += static_cast<int64_t>(att_info.num_values) *
+            DataTypeLength(att_info.data_type) * att_info.num_components;
+    if (!att_info.is_mapping_identity) {
+      size += static_cast<int64_t>(info.num_points) *
+              sizeof(AttributeValueIndex);
+    }
+  }
+  return size;
+}
+
+// Decodes a mesh from |in_buffer| into |out_mesh| and reuses the storage that
+// is already allocated by |out_mesh| where possible. Meshes encoded with
+// MESH_REALTIME_ENCODING reuse faces, attribute values and point mappings (see
+// DecodeMeshRealtime()). Other meshes are decoded by |decoder| and only their
+// faces reuse the existing storage, because the decoder creates new
+// attributes. Existing attributes and metadata of |out_mesh| are replaced.
+inline Status DecodeBufferToExistingMesh(Decoder *decoder,
+                                         DecoderBuffer *in_buffer,
+                                         Mesh *out_mesh) {
+  DecoderBuffer header_buffer(*in_buffer);
+  DracoHeader header;
+  DRACO_RETURN_IF_ERROR(
+      PointCloudDecoder::DecodeHeader(&header_buffer, &header));
+  if (header.encoder_type == TRIANGULAR_MESH &&
+      header.encoder_method == MESH_REALTIME_ENCODING) {
+    return DecodeMeshRealtime(in_buffer, out_mesh);
+  }
+  // Faces are appended by the decoder so the array is emptied but it keeps its
+  // capacity.
+  out_mesh->SetNumFaces(0);
+  out_mesh->set_num_points(0);
+  out_mesh->AddMetadata(nullptr);
+  while (out_mesh->num_attributes() > 0) {
+    out_mesh->DeleteAttribute(out_mesh->num_attributes() - 1);
+  }
+  return decoder->DecodeBufferToGeometry(in_buffer, out_mesh);
+}
+
+}  // namespace draco
+
+#endif  // DRACO_COMPRESSION_GEOMETRY_INFO_H_
@@ -0,0 +1,489 @@
+// Copyright 2020 The Draco Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DRACO_COMPRESSION_MESH_MESH_COMPONENTS_CODING_H_
+#define DRACO_COMPRESSION_MESH_MESH_COMPONENTS_CODING_H_
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "draco/compression/config/compression_shared.h"
+#include "draco/compression/decode.h"
+#include "draco/compression/encode.h"
+#include "draco/core/decoder_buffer.h"
+#include "draco/core/encoder_buffer.h"
+#include "draco/core/parallel_for.h"
+#include "draco/core/quantization_utils.h"
+#include "draco/core/status_or.h"
+#include "draco/core/varint_decoding.h"
+#include "draco/core/varint_encoding.h"
+#include "draco/mesh/mesh.h"
+#include "draco/metadata/geometry_metadata.h"
+
+namespace draco {
+
+// Connected components are grouped into sub-streams of at least this many
+// faces so that meshes with many tiny components do not pay the header of a
+// full draco stream per component.
+static constexpr int kMinFacesPerMeshComponentStream = 1 << 12;
+
+// Computes connected components of |mesh|. Faces are connected when they share
+// a position value (or a point when the mesh has no position attribute), the
+// same way as the edgebreaker connectivity. Components are numbered in the
+// order of their first face. Stores the component of each face in
+// |face_components| and returns the number of components.
+inline int ComputeMeshComponents(const Mesh &mesh,
+                                 std::vector<int> *face_components) {
+  const PointAttribute *const pos_att =
+      mesh.GetNamedAttribute(GeometryAttribute::POSITION);
+  const uint32_t num_vertices = pos_att != nullptr
+                                    ? static_cast<uint32_t>(pos_att->size())
+                                    : mesh.num_points();
+  const auto vertex = [&mesh, pos_att](FaceIndex f, int c) {
+    const PointIndex p = mesh.face(f)[c];
+    return pos_att != nullptr ? pos_att->mapped_index(p).value() : p.value();
+  };
+  // Union-find over vertices with path halving.
+  std::vector<uint32_t> parents(num_vertices);
+  for (uint32_t v = 0; v < num_vertices; ++v) {
+    parents[v] = v;
+  }
+  const auto find_root = [&parents](uint32_t v) {
+    while (parents[v] != v) {
+      parents[v] = parents[parents[v]];
+      v = parents[v];
+    }
+    return v;
+  };
+  for (FaceIndex f(0); f < mesh.num_faces(); ++f) {
+    const uint32_t root = find_root(vertex(f, 0));
+    for (int c = 1; c < 3; ++c) {
+      const uint32_t other_root = find_root(vertex(f, c));
+      if (other_root != root) {
+        parents[other_root] = root;
+      }
+    }
+  }
+  std::vector<int> root_components(num_vertices, -1);
+  int num_components = 0;
+  face_components->resize(mesh.num_faces());
+  for (FaceIndex f(0); f < mesh.num_faces(); ++f) {
+    const uint32_t root = find_root(vertex(f, 0));
+    if (root_components[root] < 0) {
+      root_components[root] = num_components++;
+    }
+    (*face_components)[f.value()] = root_components[root];
+  }
+  return num_components;
+}
+
+// Creates a new mesh from the faces |faces| of |mesh|. Only points and
+// attribute values used by the faces are copied. Attributes keep their order,
+// unique ids, element types and point mapping kind. Fails when an attribute
+// with identity mapping has no value for one of the points.
+inline StatusOr<std::unique_ptr<Mesh>> ExtractMeshFaces(
+    const Mesh &mesh, const std::vector<FaceIndex> &faces) {
+  std::unique_ptr<Mesh> out_mesh(new Mesh());
+  std::vector<PointIndex> point_map(mesh.num_points(), kInvalidPointIndex);
+  std::vector<PointIndex> new_points;
+  out_mesh->SetNumFaces(faces.size());
+  for (size_t i = 0; i < faces.size(); ++i) {
+    const Mesh::Face &face = mesh.face(faces[i]);
+    Mesh::Face new_face;
+    for (int c = 0; c < 3; ++c) {
+      PointIndex &new_point = point_map[face[c].value()];
+      if (new_point == kInvalidPointIndex) {
+        new_point = PointIndex(static_cast<uint32_t>(new_points.size()));
+        new_points.push_back(face[c]);
+      }
+      new_face[c] = new_point;
+    }
+    out_mesh->SetFace(FaceIndex(static_cast<uint32_t>(i)), new_face);
+  }
+  out_mesh->set_num_points(static_cast<uint32_t>(new_points.size()));
+
+  std::vector<AttributeValueIndex> value_map;
+  for (int att_id = 0; att_id < mesh.num_attributes(); ++att_id) {
+    const PointAttribute *const src_att = mesh.attribute(att_id);
+    std::unique_ptr<PointAttribute> att(new PointAttribute());
+    att->Init(src_att->attribute_type(), src_att->num_components(),
+              src_att->data_type(), src_att->normalized(), 0);
+    att->set_unique_id(src_att->unique_id());
+    std::vector<AttributeValueIndex> used_values;
+    if (src_att->is_mapping_identity()) {
+      // Values stay indexed by points, so every point needs its own value.
+      att->SetIdentityMapping();
+      used_values.reserve(new_points.size());
+      for (size_t p = 0; p < new_points.size(); ++p) {
+        if (new_points[p].value() >= src_att->size()) {
+          return Status(Status::DRACO_ERROR,
+                        "Attribute has fewer values than points.");
+        }
+        used_values.push_back(AttributeValueIndex(new_points[p].value()));
+      }
+    } else {
+      value_map.assign(src_att->size(), kInvalidAttributeValueIndex);
+      att->SetExplicitMapping(new_points.size());
+      for (size_t p = 0; p < new_points.size(); ++p) {
+        const AttributeValueIndex src_value =
+            src_att->mapped_index(new_points[p]);
+        if (src_value.value() >= value_map.size()) {
+          continue;  // Point without an attribute value.
+        }
+        AttributeValueIndex &value = value_map[src_value.value()];
+        if (value == kInvalidAttributeValueIndex) {
+          value =
+              AttributeValueIndex(static_cast<uint32_t>(used_values.size()));
+          used_values.push_back(src_value);
+        }
+        att->SetPointMapEntry(PointIndex(static_cast<uint32_t>(p)), value);
+      }
+    }
+    att->Reset(used_values.size());
+    for (size_t v = 0; v < used_values.size(); ++v) {
+      att->SetAttributeValue(AttributeValueIndex(static_cast<uint32_t>(v)),
+                             src_att->GetAddress(used_values[v]));
+    }
+    const int new_att_id = out_mesh->AddAttribute(std::move(att));
+    out_mesh->SetAttributeElementType(new_att_id,
+                                      mesh.GetAttributeElementType(att_id));
+  }
+  return out_mesh;
+}
+
+// Appends faces, points and attribute values of |src| to |dst|. When |dst| is
+// empty, its attributes are created to match |src|. Otherwise both meshes must
+// have the same attribute layout.
+inline Status AppendMesh(const Mesh &src, Mesh *dst) {
+  const bool is_dst_empty =
+      dst->num_points() == 0 && dst->num_attributes() == 0;
+  if (!is_dst_empty && dst->num_attributes() != src.num_attributes()) {
+    return Status(Status::DRACO_ERROR, "Incompatible mesh attributes.");
+  }
+  const uint32_t point_offset = dst->num_points();
+  const uint32_t face_offset = dst->num_faces();
+  const uint32_t num_points = point_offset + src.num_points();
+  for (int att_id = 0; att_id < src.num_attributes(); ++att_id) {
+    const PointAttribute *const src_att = src.attribute(att_id);
+    if (is_dst_empty) {
+      std::unique_ptr<PointAttribute> att(new PointAttribute());
+      att->Init(src_att->attribute_type(), src_att->num_components(),
+                src_att->data_type(), src_att->normalized(), 0);
+      att->set_unique_id(src_att->unique_id());
+      att->SetExplicitMapping(0);
+      const int new_att_id = dst->AddAttribute(std::move(att));
+      dst->SetAttributeElementType(new_att_id,
+                                   src.GetAttributeElementType(att_id));
+    }
+    PointAttribute *const dst_att = dst->attribute(att_id);
+    if (dst_att->attribute_type() != src_att->attribute_type() ||
+        dst_att->num_components() != src_att->num_components() ||
+        dst_att->data_type() != src_att->data_type()) {
+      return Status(Status::DRACO_ERROR, "Incompatible mesh attributes.");
+    }
+    const uint32_t value_offset = static_cast<uint32_t>(dst_att->size());
+    dst_att->Resize(value_offset + src_att->size());
+    if (src_att->size() > 0) {
+      dst_att->buffer()->Write(value_offset * dst_att->byte_stride(),
+                               src_att->GetAddress(AttributeValueIndex(0)),
+                               src_att->size() * src_att->byte_stride());
+    }
+    dst_att->SetExplicitMapping(num_points);
+    for (PointIndex p(0); p < src.num_points(); ++p) {
+      dst_att->SetPointMapEntry(
+          PointIndex(point_offset + p.value()),
+          AttributeValueIndex(value_offset + src_att->mapped_index(p).value()));
+    }
+  }
+  dst->set_num_points(num_points);
+  dst->SetNumFaces(face_offset + src.num_faces());
+  for (FaceIndex f(0); f < src.num_faces(); ++f) {
+    const Mesh::Face &face = src.face(f);
+    dst->SetFace(FaceIndex(face_offset + f.value()),
+                 {{PointIndex(point_offset + face[0].value()),
+                   PointIndex(point_offset + face[1].value()),
+                   PointIndex(point_offset + face[2].value())}});
+  }
+  return OkStatus();
+}
+
+// Returns a deep copy of |metadata| including all attribute metadata.
+inline std::unique_ptr<GeometryMetadata> CopyGeometryMetadata(
+    const GeometryMetadata &metadata) {
+  std::unique_ptr<GeometryMetadata> copy(
+      new GeometryMetadata(static_cast<const Metadata &>(metadata)));
+  for (const auto &att_metadata : metadata.attribute_metadatas()) {
+    std::unique_ptr<AttributeMetadata> att_copy(
+        new AttributeMetadata(static_cast<const Metadata &>(*att_metadata)));
+    att_copy->set_att_unique_id(att_metadata->att_unique_id());
+    copy->AddAttributeMetadata(std::move(att_copy));
+  }
+  return copy;
+}
+
+// Sets explicit quantization parameters in |encoder| for all quantized float
+// attributes of |mesh| that do not have them yet. The origin and range cover
+// all values of all attributes of the same type, so every sub-stream uses the
+// same quantization grid and geometry shared by different sub-streams is
+// quantized to the same values. Normals are skipped because they are not
+// quantized on a grid.
+inline Status SetMeshQuantizationGrid(const Mesh &mesh, Encoder *encoder) {
+  for (int type = 0; type < GeometryAttribute::NAMED_ATTRIBUTES_COUNT;
+       ++type) {
+    const GeometryAttribute::Type att_type =
+        static_cast<GeometryAttribute::Type>(type);
+    const int quantization_bits =
+        encoder->options().GetAttributeInt(att_type, "quantization_bits", -1);
+    if (att_type == GeometryAttribute::NORMAL || quantization_bits <= 0 ||
+        encoder->options().IsAttributeOptionSet(att_type,
+                                                "quantization_origin")) {
+      continue;
+    }
+    int num_components = 0;
+    std::vector<float> min_values, max_values;
+    std::vector<float> att_min_values, att_max_values, values;
+    for (int att_id = 0; att_id < mesh.num_attributes(); ++att_id) {
+      const PointAttribute *const att = mesh.attribute(att_id);
+      if (att->attribute_type() != att_type ||
+          att->data_type() != DT_FLOAT32 || att->size() == 0) {
+        continue;
+      }
+      if (num_components == 0) {
+        num_components = att->num_components();
+      } else if (num_components != att->num_components()) {
+        return Status(Status::DRACO_ERROR,
+                      "Attributes of the same type must have the same number "
+                      "of components.");
+      }
+      const int num_entries = static_cast<int>(att->size());
+      values.resize(static_cast<size_t>(num_entries) * num_components);
+      for (int i = 0; i < num_entries; ++i) {
+        memcpy(&values[static_cast<size_t>(i) * num_components],
+               att->GetAddress(AttributeValueIndex(i)),
+               sizeof(float) * num_components);
+      }
+      att_min_values.resize(num_components);
+      att_max_values.resize(num_components);
+      ComputeMinMaxValues(values.data(), num_entries, num_components,
+                          att_min_values.data(), att_max_values.data());
+      if (min_values.empty()) {
+        min_values = att_min_values;
+        max_values = att_max_values;
+        continue;
+      }
+      for (int c = 0; c < num_components; ++c) {
+        min_values[c] = std::min(min_values[c], att_min_values[c]);
+        max_values[c] = std::max(max_values[c], att_max_values[c]);
+      }
+    }
+    if (num_components == 0) {
+      continue;
+    }
+    float range = 0.f;
+    for (int c = 0; c < num_components; ++c) {
+      range = std::max(range, max_values[c] - min_values[c]);
+    }
+    if (range == 0.f) {
+      range = 1.f;
+    }
+    encoder->SetAttributeExplicitQuantization(att_type, quantization_bits,
+                                              num_components,
+                                              min_values.data(), range);
+  }
+  return OkStatus();
+}
+
+// Encodes |mesh| with the MESH_COMPONENTS_ENCODING method as a set of
+// independent sub-streams, each holding one or more connected components
+// encoded with a copy of |encoder|. The sub-streams are encoded in parallel on
+// up to |num_threads| threads and can be decoded concurrently with
+// DecodeMeshComponents(). The format is a Draco header, the number of
+// sub-streams, the byte size of each sub-stream and the sub-streams, which are
+// complete draco streams. The output does not depend on |num_threads|.
+//
+// All sub-streams share one quantization grid computed from the whole mesh
+// (see SetMeshQuantizationGrid()). Metadata of |mesh| is stored in the first
+// sub-stream. Points that are not used by any face are not encoded and meshes
+// without faces are rejected; use Encoder::EncodePointCloudToBuffer() for
+// them.
+inline Status EncodeMeshComponents(const Mesh &mesh, const Encoder &encoder,
+                                   int num_threads,
+                                   EncoderBuffer *out_buffer) {
+  if (mesh.num_faces() == 0) {
+    return Status(Status::DRACO_ERROR, "Mesh has no faces.");
+  }
+  Encoder components_encoder = encoder;
+  DRACO_RETURN_IF_ERROR(SetMeshQuantizationGrid(mesh, &components_encoder));
+
+  std::vector<int> face_components;
+  const int num_components = ComputeMeshComponents(mesh, &face_components);
+
+  // Assign consecutive components to sub-streams.
+  std::vector<int> component_faces(num_components, 0);
+  for (size_t f = 0; f < face_components.size(); ++f) {
+    component_faces[face_components[f]]++;
+  }
+  std::vector<int> component_streams(num_components);
+  int num_streams = 0;
+  int num_stream_faces = 0;
+  for (int c = 0; c < num_components; ++c) {
+    if (num_streams == 0 ||
+        num_stream_faces >= kMinFacesPerMeshComponentStream) {
+      ++num_streams;
+      num_stream_faces = 0;
+    }
+    component_streams[c] = num_streams - 1;
+    num_stream_faces += component_faces[c];
+  }
+  std::vector<std::vector<FaceIndex>> stream_faces(num_streams);
+  for (FaceIndex f(0); f < mesh.num_faces(); ++f) {
+    stream_faces[component_streams[face_components[f.value()]]].push_back(f);
+  }
+
+  std::vector<EncoderBuffer> stream_buffers(num_streams);
+  std::vector<Status> stream_status(num_streams);
+  ParallelFor(num_streams, GetNumParallelChunks(num_streams, num_threads, 1),
+              [&](int /* chunk_id */, int64_t begin, int64_t end) {
+                for (int64_t s = begin; s < end; ++s) {
+                  auto statusor = ExtractMeshFaces(mesh, stream_faces[s]);
+                  if (!statusor.ok()) {
+                    stream_status[s] = statusor.status();
+                    continue;
+                  }
+                  const std::unique_ptr<Mesh> stream_mesh =
+                      std::move(statusor).value();
+                  if (s == 0 && mesh.GetMetadata() != nullptr) {
+                    stream_mesh->AddMetadata(
+                        CopyGeometryMetadata(*mesh.GetMetadata()));
+                  }
+                  Encoder stream_encoder = components_encoder;
+                  stream_status[s] = stream_encoder.EncodeMeshToBuffer(
+                      *stream_mesh, &stream_buffers[s]);
+                }
+              });
+  for (int s = 0; s < num_streams; ++s) {
+    DRACO_RETURN_IF_ERROR(stream_status[s]);
+  }
+  // Draco header.
+  out_buffer->Encode("DRACO", 5);
+  out_buffer->Encode(kDracoMeshBitstreamVersionMajor);
+  out_buffer->Encode(kDracoMeshBitstreamVersionMinor);
+  out_buffer->Encode(static_cast<uint8_t>(TRIANGULAR_MESH));
+  out_buffer->Encode(static_cast<uint8_t>(MESH_COMPONENTS_ENCODING));
+  out_buffer->Encode(static_cast<uint16_t>(0));
+
+  EncodeVarint(static_cast<uint32_t>(num_streams), out_buffer);
+  for (int s = 0; s < num_streams; ++s) {
+    EncodeVarint(static_cast<uint64_t>(stream_buffers[s].size()), out_buffer);
+  }
+  for (int s = 0; s < num_streams; ++s) {
+    out_buffer->Encode(stream_buffers[s].data(), stream_buffers[s].size());
+  }
+  return OkStatus();
+}
+
+// Decodes a mesh encoded by EncodeMeshComponents(). The sub-streams are
+// decoded in parallel on up to |num_threads| threads with copies of |decoder|
+// and merged in the stream order. Meshes encoded with the other methods are
+// decoded by a copy of |decoder|.
+inline StatusOr<std::unique_ptr<Mesh>> DecodeMeshComponents(
+    const Decoder &decoder, int num_threads, DecoderBuffer *in_buffer) {
+  DecoderBuffer header_buffer(*in_buffer);
+  DracoHeader header;
+  if (!header_buffer.Decode(header.draco_string, 5) ||
+      memcmp(header.draco_string, "DRACO", 5) != 0) {
+    return Status(Status::DRACO_ERROR, "Not a Draco file.");
+  }
+  if (!header_buffer.Decode(&header.version_major) ||
+      !header_buffer.Decode(&header.version_minor) ||
+      !header_buffer.Decode(&header.encoder_type) ||
+      !header_buffer.Decode(&header.encoder_method) ||
+      !header_buffer.Decode(&header.flags)) {
+    return Status(Status::IO_ERROR, "Failed to parse Draco header.");
+  }
+  if (header.encoder_type != TRIANGULAR_MESH ||
+      header.encoder_method != MESH_COMPONENTS_ENCODING) {
+    Decoder mesh_decoder = decoder;
+    return mesh_decoder.DecodeMeshFromBuffer(in_buffer);
+  }
+  if (header.version_major != kDracoMeshBitstreamVersionMajor) {
+    return Status(Status::DRACO_ERROR, "Unknown major version.");
+  }
+  *in_buffer = header_buffer;
+
+  uint32_t num_streams;
+  if (!DecodeVarint(&num_streams, in_buffer)) {
+    return Status(Status::IO_ERROR, "Failed to decode number of components.");
+  }
+  if (num_streams > static_cast<uint64_t>(in_buffer->remaining_size())) {
+    return Status(Status::DRACO_ERROR, "Invalid number of components.");
+  }
+  std::vector<uint64_t> stream_offsets(num_streams + 1, 0);
+  for (uint32_t s = 0; s < num_streams; ++s) {
+    uint64_t stream_size;
+    if (!DecodeVarint(&stream_size, in_buffer)) {
+      return Status(Status::IO_ERROR, "Failed to decode component size.");
+    }
+    const uint64_t remaining_size =
+        static_cast<uint64_t>(in_buffer->remaining_size());
+    if (stream_offsets[s] > remaining_size ||
+        stream_size > remaining_size - stream_offsets[s]) {
+      return Status(Status::IO_ERROR, "Component data out of bounds.");
+    }
+    stream_offsets[s + 1] = stream_offsets[s] + stream_size;
+  }
+  if (stream_offsets[num_streams] >
+      static_cast<uint64_t>(in_buffer->remaining_size())) {
+    return Status(Status::IO_ERROR, "Component data out of bounds.");
+  }
+  const char *const streams_data = in_buffer->data_head();
+  in_buffer->Advance(stream_offsets[num_streams]);
+
+  std::vector<std::unique_ptr<Mesh>> stream_meshes(num_streams);
+  std::vector<Status> stream_status(num_streams);
+  ParallelFor(num_streams, GetNumParallelChunks(num_streams, num_threads, 1),
+              [&](int /* chunk_id */, int64_t begin, int64_t end) {
+                for (int64_t s = begin; s < end; ++s) {
+                  DecoderBuffer stream_buffer;
+                  stream_buffer.Init(streams_data + stream_offsets[s],
+                                     stream_offsets[s + 1] - stream_offsets[s]);
+                  Decoder stream_decoder = decoder;
+                  auto statusor =
+                      stream_decoder.DecodeMeshFromBuffer(&stream_buffer);
+                  if (!statusor.ok()) {
+                    stream_status[s] = statusor.status();
+                    continue;
+                  }
+                  stream_meshes[s] = std::move(statusor).value();
+                }
+              });
+  std::unique_ptr<Mesh> mesh(new Mesh());
+  for (uint32_t s = 0; s < num_streams; ++s) {
+    DRACO_RETURN_IF_ERROR(stream_status[s]);
+    DRACO_RETURN_IF_ERROR(AppendMesh(*stream_meshes[s], mesh.get()));
+    if (s == 0 && stream_meshes[s]->GetMetadata() != nullptr) {
+      mesh->AddMetadata(CopyGeometryMetadata(*stream_meshes[s]->GetMetadata()));
+    }
+    stream_meshes[s].reset();
+  }
+  return mesh;
+}
+
+}  // namespace draco
+
+#endif  // DRACO_COMPRESSION_MESH_MESH_COMPONENTS_CODING_H_
@@ -0,0 +1,537 @@
+// Copyright 2020 The Draco Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// File providing the MESH_REALTIME_ENCODING method, which is meant for live
+// streaming of meshes that change every frame. All stages are byte oriented
+// and run close to the memory bandwidth:
+//   - Point ids of faces are delta coded against the previous point id.
+//   - Float attributes with "quantization_bits" set are quantized and delta
+//     coded against the previous attribute value.
+//   - All integer streams are coded with the Stream VByte layout from
+//     varint_block_coding.h, which acts as a light entropy stage in place of
+//     rANS. Other attributes are stored as raw bytes.
+// The stream starts with a regular Draco header so that the geometry type and
+// encoding method can be read by the standard tools.
+#ifndef DRACO_COMPRESSION_MESH_MESH_REALTIME_CODING_H_
+#define DRACO_COMPRESSION_MESH_MESH_REALTIME_CODING_H_
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "draco/compression/config/compression_shared.h"
+#include "draco/compression/encode.h"
+#include "draco/core/decoder_buffer.h"
+#include "draco/core/encoder_buffer.h"
+#include "draco/core/quantization_utils.h"
+#include "draco/core/status_or.h"
+#include "draco/core/varint_block_coding.h"
+#include "draco/core/varint_decoding.h"
+#include "draco/core/varint_encoding.h"
+#include "draco/mesh/mesh.h"
+
+namespace draco {
+
+// Methods used for coding attribute values by MESH_REALTIME_ENCODING.
+enum MeshRealtimeAttributeCoding {
+  // Values are stored as raw bytes.
+  MESH_REALTIME_ATTRIBUTE_RAW = 0,
+  // Values are quantized and delta coded against the previous value.
+  MESH_REALTIME_ATTRIBUTE_QUANTIZED_DELTA = 1,
+};
+
+namespace {
+
+// Replaces |values| with differences to the value |stride| entries before.
+// The first |stride| values are kept. Values are processed from the back so
+// that the operation can be done in place.
+inline void ComputeRealtimeDeltas(int32_t *values, int num_values,
+                                  int stride) {
+  for (int i = num_values - 1; i >= stride; --i) {
+    values[i] = static_cast<int32_t>(static_cast<uint32_t>(values[i]) -
+                                     static_cast<uint32_t>(values[i - stride]));
+  }
+}
+
+// Inverse of ComputeRealtimeDeltas().
+inline void AccumulateRealtimeDeltas(int32_t *values, int num_values,
+                                     int stride) {
+  for (int i = stride; i < num_values; ++i) {
+    values[i] = static_cast<int32_t>(static_cast<uint32_t>(values[i]) +
+                                     static_cast<uint32_t>(values[i - stride]));
+  }
+}
+
+// Encodes the quantized and delta coded values of a float attribute |att|.
+// |scratch_values| is used as temporary storage for the quantized values.
+inline bool EncodeRealtimeQuantizedAttribute(
+    const PointAttribute &att, int quantization_bits,
+    std::vector<int32_t> *scratch_values, EncoderBuffer *out_buffer) {
+  const int num_components = att.num_components();
+  const int num_entries = static_cast<int>(att.size());
+  const int num_values = num_entries * num_components;
+  // Gather the values when they are not stored contiguously.
+  const int64_t entry_size = sizeof(float) * num_components;
+  std::vector<float> gathered_values;
+  const float *values = nullptr;
+  if (att.byte_stride() == entry_size) {
+    values = reinterpret_cast<const float *>(
+        att.GetAddress(AttributeValueIndex(0)));
+  } else {
+    gathered_values.resize(num_values);
+    for (int i = 0; i < num_entries; ++i) {
+      memcpy(&gathered_values[i * num_components],
+             att.GetAddress(AttributeValueIndex(i)), entry_size);
+    }
+    values = gathered_values.data();
+  }
+  std::vector<float> min_values(num_components);
+  std::vector<float> max_values(num_components);
+  ComputeMinMaxValues(values, num_entries, num_components, min_values.data(),
+                      max_values.data());
+  float range = 0.f;
+  for (int c = 0; c < num_components; ++c) {
+    range = std::max(range, max_values[c] - min_values[c]);
+  }
+  if (range == 0.f) {
+    range = 1.f;
+  }
+  const int32_t max_quantized_value = (1 << quantization_bits) - 1;
+  Quantizer quantizer;
+  quantizer.Init(range, max_quantized_value);
+  scratch_values->resize(num_values);
+  int32_t *const quantized_values = scratch_values->data();
+  quantizer.QuantizeFloats(values, num_entries, num_components,
+                           min_values.data(), quantized_values);
+  ComputeRealtimeDeltas(quantized_values, num_values, num_components);
+
+  out_buffer->Encode(static_cast<uint8_t>(quantization_bits));
+  out_buffer->Encode(min_values.data(), sizeof(float) * num_components);
+  out_buffer->Encode(range);
+  return EncodeVarints(quantized_values, num_values,
+                       VARINT_CODING_STREAM_VBYTE, out_buffer);
+}
+
+// Decodes values encoded by EncodeRealtimeQuantizedAttribute() into |att|.
+// |scratch_values| is used as temporary storage for the quantized values.
+inline bool DecodeRealtimeQuantizedAttribute(
+    DecoderBuffer *in_buffer, std::vector<int32_t> *scratch_values,
+    PointAttribute *att) {
+  const int num_components = att->num_components();
+  const int num_entries = static_cast<int>(att->size());
+  const int num_values = num_entries * num_components;
+  uint8_t quantization_bits;
+  if (!in_buffer->Decode(&quantization_bits) || quantization_bits < 1 ||
+      quantization_bits > 30) {
+    return false;
+  }
+  std::vector<float> min_values(num_components);
+  float range;
+  if (!in_buffer->Decode(min_values.data(), sizeof(float) * num_components) ||
+      !in_buffer->Decode(&range)) {
+    return false;
+  }
+  scratch_values->resize(num_values);
+  int32_t *const quantized_values = scratch_values->data();
+  if (!DecodeVarints(num_values, in_buffer, quantized_values)) {
+    return false;
+  }
+  AccumulateRealtimeDeltas(quantized_values, num_values, num_components);
+  Dequantizer dequantizer;
+  if (!dequantizer.Init(range, (1 << quantization_bits) - 1)) {
+    return false;
+  }
+  if (num_entries > 0) {
+    dequantizer.DequantizeFloats(
+        quantized_values, num_entries, num_components,
+        min_values.data(),
+        reinterpret_cast<float *>(att->GetAddress(AttributeValueIndex(0))));
+  }
+  return true;
+}
+
+// Returns false when |num_values| values can't be stored in the remaining
+// data of |in_buffer|. Each coded value uses at least one byte.
+inline bool CheckRealtimeValueCount(uint64_t num_values,
+                                    const DecoderBuffer &in_buffer) {
+  return num_values <= static_cast<uint64_t>(in_buffer.remaining_size()) &&
+         num_values <= static_cast<uint64_t>(std::numeric_limits<int>::max());
+}
+
+}  // namespace
+
+// Encodes |mesh| with the MESH_REALTIME_ENCODING method. Float attributes are
+// quantized when "quantization_bits" is set for their attribute type in the
+// options of |encoder|. All other options are ignored. Metadata of |mesh| is
+// not encoded. Meshes with more than 255 attributes are rejected.
+inline Status EncodeMeshRealtime(const Mesh &mesh, const Encoder &encoder,
+                                 EncoderBuffer *out_buffer) {
+  // The number of attributes is stored in a single byte.
+  if (mesh.num_attributes() > std::numeric_limits<uint8_t>::max()) {
+    return Status(Status::DRACO_ERROR, "Too many attributes.");
+  }
+  // Draco header.
+  out_buffer->Encode("DRACO", 5);
+  out_buffer->Encode(kDracoMeshBitstreamVersionMajor);
+  out_buffer->Encode(kDracoMeshBitstreamVersionMinor);
+  out_buffer->Encode(static_cast<uint8_t>(TRIANGULAR_MESH));
+  out_buffer->Encode(static_cast<uint8_t>(MESH_REALTIME_ENCODING));
+  out_buffer->Encode(static_cast<uint16_t>(0));
+
+  // Connectivity.
+  const uint32_t num_faces = mesh.num_faces();
+  EncodeVarint(num_faces, out_buffer);
+  EncodeVarint(mesh.num_points(), out_buffer);
+  // Temporary storage for the delta coded values of the connectivity, the
+  // mappings and the quantized attributes.
+  std::vector<int32_t> scratch_values(3 * static_cast<size_t>(num_faces));
+  int32_t *const indices = scratch_values.data();
+  for (FaceIndex f(0); f < num_faces; ++f) {
+    const Mesh::Face &face = mesh.face(f);
+    for (int c = 0; c < 3; ++c) {
+      indices[3 * f.value() + c] = static_cast<int32_t>(face[c].value());
+    }
+  }
+  const int num_indices = static_cast<int>(scratch_values.size());
+  ComputeRealtimeDeltas(indices, num_indices, 1);
+  if (!EncodeVarints(indices, num_indices, VARINT_CODING_STREAM_VBYTE,
+                     out_buffer)) {
+    return Status(Status::DRACO_ERROR, "Failed to encode connectivity.");
+  }
+
+  // Attributes.
+  out_buffer->Encode(static_cast<uint8_t>(mesh.num_attributes()));
+  for (int att_id = 0; att_id < mesh.num_attributes(); ++att_id) {
+    const PointAttribute *const att = mesh.attribute(att_id);
+    out_buffer->Encode(static_cast<uint8_t>(att->attribute_type()));
+    out_buffer->Encode(static_cast<uint8_t>(att->data_type()));
+    out_buffer->Encode(static_cast<uint8_t>(att->num_components()));
+    out_buffer->Encode(static_cast<uint8_t>(att->normalized()));
+    out_buffer->Encode(
+        static_cast<uint8_t>(mesh.GetAttributeElementType(att_id)));
+    EncodeVarint(att->unique_id(), out_buffer);
+    EncodeVarint(static_cast<uint32_t>(att->size()), out_buffer);
+
+    // Point to attribute value mapping.
+    out_buffer->Encode(static_cast<uint8_t>(att->is_mapping_identity()));
+    if (!att->is_mapping_identity()) {
+      const int num_points = static_cast<int>(mesh.num_points());
+      scratch_values.resize(num_points);
+      int32_t *const mapping = scratch_values.data();
+      for (PointIndex p(0); p < num_points; ++p) {
+        mapping[p.value()] = static_cast<int32_t>(att->mapped_index(p).value());
+      }
+      ComputeRealtimeDeltas(mapping, num_points, 1);
+      if (!EncodeVarints(mapping, num_points, VARINT_CODING_STREAM_VBYTE,
+                         out_buffer)) {
+        return Status(Status::DRACO_ERROR, "Failed to encode mapping.");
+      }
+    }
+
+    // Attribute values.
+    const int quantization_bits = encoder.options().GetAttributeInt(
+        att->attribute_type(), "quantization_bits", -1);
+    if (att->data_type() == DT_FLOAT32 && att->size() > 0 &&
+        quantization_bits >= 1 && quantization_bits <= 30) {
+      out_buffer->Encode(
+          static_cast<uint8_t>(MESH_REALTIME_ATTRIBUTE_QUANTIZED_DELTA));
+      if (!EncodeRealtimeQuantizedAttribute(*att, quantization_bits,
+                                            &scratch_values, out_buffer)) {
+        return Status(Status::DRACO_ERROR, "Failed to encode attribute.");
+      }
+      continue;
+    }
+    out_buffer->Encode(static_cast<uint8_t>(MESH_REALTIME_ATTRIBUTE_RAW));
+    const int64_t entry_size =
+        DataTypeLength(att->data_type()) * att->num_components();
+    if (att->byte_stride() == entry_size) {
+      if (att->size() > 0) {
+        out_buffer->Encode(att->GetAddress(AttributeValueIndex(0)),
+                           entry_size * att->size());
+      }
+    } else {
+      for (AttributeValueIndex i(0); i < att->size(); ++i) {
+        out_buffer->Encode(att->GetAddress(i), entry_size);
+      }
+    }
+  }
+  return OkStatus();
+}
+
+// Description of an attribute stored in front of its values by
+// EncodeMeshRealtime().
+struct MeshRealtimeAttributeHeader {
+  GeometryAttribute::Type attribute_type;
+  DataType data_type;
+  int num_components;
+  bool normalized;
+  MeshAttributeElementType element_type;
+  uint32_t unique_id;
+  uint32_t num_values;
+  bool is_mapping_identity;
+};
+
+// Decodes the Draco header and the mesh size of a stream encoded by
+// EncodeMeshRealtime(). On success, |in_buffer| is positioned at the encoded
+// point ids of faces.
+inline Status DecodeMeshRealtimeHeader(DecoderBuffer *in_buffer,
+                                       uint32_t *out_num_faces,
+                                       uint32_t *out_num_points) {
+  DracoHeader header;
+  if (!in_buffer->Decode(header.draco_string, 5) ||
+      memcmp(header.draco_string, "DRACO", 5) != 0) {
+    return Status(Status::DRACO_ERROR, "Not a Draco file.");
+  }
+  if (!in_buffer->Decode(&header.version_major) ||
+      !in_buffer->Decode(&header.version_minor) ||
+      !in_buffer->Decode(&header.encoder_type) ||
+      !in_buffer->Decode(&header.encoder_method) ||
+      !in_buffer->Decode(&header.flags)) {
+    return Status(Status::IO_ERROR, "Failed to parse Draco header.");
+  }
+  if (header.encoder_type != TRIANGULAR_MESH ||
+      header.encoder_method != MESH_REALTIME_ENCODING) {
+    return Status(Status::DRACO_ERROR, "Unsupported encoding method.");
+  }
+  in_buffer->set_bitstream_version(
+      DRACO_BITSTREAM_VERSION(header.version_major, header.version_minor));
+  if (!DecodeVarint(out_num_faces, in_buffer) ||
+      !DecodeVarint(out_num_points, in_buffer)) {
+    return Status(Status::IO_ERROR, "Failed to decode mesh size.");
+  }
+  if (!CheckRealtimeValueCount(3 * static_cast<uint64_t>(*out_num_faces),
+                               *in_buffer)) {
+    return Status(Status::DRACO_ERROR, "Invalid number of faces.");
+  }
+  return OkStatus();
+}
+
+// Decodes the description of an attribute into |out_header|. On success,
+// |in_buffer| is positioned at the attribute data that can be either decoded
+// or skipped with SkipMeshRealtimeAttributeData().
+inline Status DecodeMeshRealtimeAttributeHeader(
+    DecoderBuffer *in_buffer, MeshRealtimeAttributeHeader *out_header) {
+  uint8_t attribute_type, data_type, num_components, normalized, element_type,
+      is_mapping_identity;
+  uint32_t unique_id, num_values;
+  if (!in_buffer->Decode(&attribute_type) || !in_buffer->Decode(&data_type) ||
+      !in_buffer->Decode(&num_components) || !in_buffer->Decode(&normalized) ||
+      !in_buffer->Decode(&element_type) ||
+      !DecodeVarint(&unique_id, in_buffer) ||
+      !DecodeVarint(&num_values, in_buffer) ||
+      !in_buffer->Decode(&is_mapping_identity)) {
+    return Status(Status::IO_ERROR, "Failed to decode attribute header.");
+  }
+  if (attribute_type >= GeometryAttribute::NAMED_ATTRIBUTES_COUNT ||
+      data_type == DT_INVALID || data_type >= DT_TYPES_COUNT ||
+      num_components == 0 || element_type > MESH_CORNER_ATTRIBUTE) {
+    return Status(Status::DRACO_ERROR, "Invalid attribute header.");
+  }
+  if (!CheckRealtimeValueCount(num_values, *in_buffer) ||
+      !CheckRealtimeValueCount(
+          static_cast<uint64_t>(num_values) * num_components, *in_buffer)) {
+    return Status(Status::DRACO_ERROR, "Invalid number of values.");
+  }
+  out_header->attribute_type =
+      static_cast<GeometryAttribute::Type>(attribute_type);
+  out_header->data_type = static_cast<DataType>(data_type);
+  out_header->num_components = num_components;
+  out_header->normalized = normalized != 0;
+  out_header->element_type =
+      static_cast<MeshAttributeElementType>(element_type);
+  out_header->unique_id = unique_id;
+  out_header->num_values = num_values;
+  out_header->is_mapping_identity = is_mapping_identity != 0;
+  return OkStatus();
+}
+
+// Advances |in_buffer| past the mapping and the values of an attribute
+// described by |header| without decoding them.
+inline Status SkipMeshRealtimeAttributeData(
+    const MeshRealtimeAttributeHeader &header, uint32_t num_points,
+    DecoderBuffer *in_buffer) {
+  if (!header.is_mapping_identity &&
+      (!CheckRealtimeValueCount(num_points, *in_buffer) ||
+       !SkipVarints(static_cast<int>(num_points), in_buffer))) {
+    return Status(Status::IO_ERROR, "Failed to decode mapping.");
+  }
+  const int num_values =
+      static_cast<int>(header.num_values) * header.num_components;
+  uint8_t coding;
+  if (!in_buffer->Decode(&coding)) {
+    return Status(Status::IO_ERROR, "Failed to decode attribute.");
+  }
+  if (coding == MESH_REALTIME_ATTRIBUTE_QUANTIZED_DELTA &&
+      header.data_type == DT_FLOAT32) {
+    // Quantization bits, minimum values and range precede the values.
+    const int64_t params_size =
+        1 + sizeof(float) * (header.num_components + 1);
+    if (in_buffer->remaining_size() < params_size) {
+      return Status(Status::IO_ERROR, "Failed to decode attribute.");
+    }
+    in_buffer->Advance(params_size);
+    if (!SkipVarints(num_values, in_buffer)) {
+      return Status(Status::IO_ERROR, "Failed to decode attribute.");
+    }
+  } else if (coding == MESH_REALTIME_ATTRIBUTE_RAW) {
+    const int64_t data_size =
+        static_cast<int64_t>(DataTypeLength(header.data_type)) * num_values;
+    if (in_buffer->remaining_size() < data_size) {
+      return Status(Status::IO_ERROR, "Failed to decode attribute.");
+    }
+    in_buffer->Advance(data_size);
+  } else {
+    return Status(Status::DRACO_ERROR, "Invalid attribute coding.");
+  }
+  return OkStatus();
+}
+
+// Decodes a mesh encoded by EncodeMeshRealtime() into |out_mesh|. Storage that
+// is already allocated by |out_mesh| is reused: the face array keeps its
+// capacity and attributes whose type and layout match the decoded ones keep
+// their value buffers and point mappings. Other attributes and metadata of
+// |out_mesh| are removed. Decoding the frames of a stream into one Mesh
+// therefore stops allocating once the largest frame was seen.
+inline Status DecodeMeshRealtime(DecoderBuffer *in_buffer, Mesh *out_mesh) {
+  // Connectivity.
+  uint32_t num_faces, num_points;
+  DRACO_RETURN_IF_ERROR(
+      DecodeMeshRealtimeHeader(in_buffer, &num_faces, &num_points));
+  const int num_indices = 3 * static_cast<int>(num_faces);
+  // Temporary storage for the decoded values of the connectivity, the mappings
+  // and the quantized attributes.
+  std::vector<int32_t> scratch_values(num_indices);
+  const int32_t *const indices = scratch_values.data();
+  if (!DecodeVarints(num_indices, in_buffer, scratch_values.data())) {
+    return Status(Status::IO_ERROR, "Failed to decode connectivity.");
+  }
+  AccumulateRealtimeDeltas(scratch_values.data(), num_indices, 1);
+  out_mesh->AddMetadata(nullptr);
+  out_mesh->set_num_points(num_points);
+  out_mesh->SetNumFaces(num_faces);
+  for (FaceIndex f(0); f < num_faces; ++f) {
+    Mesh::Face face;
+    for (int c = 0; c < 3; ++c) {
+      const uint32_t index = static_cast<uint32_t>(indices[3 * f.value() + c]);
+      if (index >= num_points) {
+        return Status(Status::DRACO_ERROR, "Invalid point id.");
+      }
+      face[c] = PointIndex(index);
+    }
+    out_mesh->SetFace(f, face);
+  }
+
+  // Attributes.
+  uint8_t num_attributes;
+  if (!in_buffer->Decode(&num_attributes)) {
+    return Status(Status::IO_ERROR, "Failed to decode attributes.");
+  }
+  for (int att_id = 0; att_id < num_attributes; ++att_id) {
+    MeshRealtimeAttributeHeader header;
+    DRACO_RETURN_IF_ERROR(
+        DecodeMeshRealtimeAttributeHeader(in_buffer, &header));
+    PointAttribute *att = nullptr;
+    if (att_id < out_mesh->num_attributes()) {
+      att = out_mesh->attribute(att_id);
+      if (att->attribute_type() != header.attribute_type ||
+          att->data_type() != header.data_type ||
+          att->num_components() != header.num_components ||
+          att->normalized() != header.normalized) {
+        // The existing attribute can't be reused. Remove it together with all
+        // following attributes so that the new one gets the same id.
+        while (out_mesh->num_attributes() > att_id) {
+          out_mesh->DeleteAttribute(out_mesh->num_attributes() - 1);
+        }
+        att = nullptr;
+      }
+    }
+    if (att == nullptr) {
+      std::unique_ptr<PointAttribute> new_att(new PointAttribute());
+      new_att->Init(header.attribute_type, header.num_components,
+                    header.data_type, header.normalized, 0);
+      att = out_mesh->attribute(out_mesh->AddAttribute(std::move(new_att)));
+    }
+    att->set_unique_id(header.unique_id);
+    out_mesh->SetAttributeElementType(att_id, header.element_type);
+    if (!att->Reset(header.num_values)) {
+      return Status(Status::DRACO_ERROR, "Failed to allocate attribute.");
+    }
+
+    // Point to attribute value mapping.
+    if (!header.is_mapping_identity) {
+      if (!CheckRealtimeValueCount(num_points, *in_buffer)) {
+        return Status(Status::DRACO_ERROR, "Invalid attribute mapping.");
+      }
+      scratch_values.resize(num_points);
+      int32_t *const mapping = scratch_values.data();
+      if (!DecodeVarints(static_cast<int>(num_points), in_buffer, mapping)) {
+        return Status(Status::IO_ERROR, "Failed to decode mapping.");
+      }
+      AccumulateRealtimeDeltas(mapping, static_cast<int>(num_points), 1);
+      att->SetExplicitMapping(num_points);
+      for (PointIndex p(0); p < num_points; ++p) {
+        const uint32_t value = static_cast<uint32_t>(mapping[p.value()]);
+        if (value >= header.num_values) {
+          return Status(Status::DRACO_ERROR, "Invalid attribute mapping.");
+        }
+        att->SetPointMapEntry(p, AttributeValueIndex(value));
+      }
+    } else if (header.num_values < num_points) {
+      return Status(Status::DRACO_ERROR, "Invalid number of values.");
+    } else {
+      att->SetIdentityMapping();
+    }
+
+    // Attribute values.
+    uint8_t coding;
+    if (!in_buffer->Decode(&coding)) {
+      return Status(Status::IO_ERROR, "Failed to decode attribute.");
+    }
+    if (coding == MESH_REALTIME_ATTRIBUTE_QUANTIZED_DELTA &&
+        header.data_type == DT_FLOAT32) {
+      if (!DecodeRealtimeQuantizedAttribute(in_buffer, &scratch_values,
+                                            att)) {
+        return Status(Status::IO_ERROR, "Failed to decode attribute.");
+      }
+    } else if (coding == MESH_REALTIME_ATTRIBUTE_RAW) {
+      if (header.num_values > 0 &&
+          !in_buffer->Decode(att->GetAddress(AttributeValueIndex(0)),
+                             att->byte_stride() * header.num_values)) {
+        return Status(Status::IO_ERROR, "Failed to decode attribute.");
+      }
+    } else {
+      return Status(Status::DRACO_ERROR, "Invalid attribute coding.");
+    }
+  }
+  while (out_mesh->num_attributes() > num_attributes) {
+    out_mesh->DeleteAttribute(out_mesh->num_attributes() - 1);
+  }
+  return OkStatus();
+}
+
+// Decodes a mesh encoded by EncodeMeshRealtime() into a new Mesh.
+inline StatusOr<std::unique_ptr<Mesh>> DecodeMeshRealtime(
+    DecoderBuffer *in_buffer) {
+  std::unique_ptr<Mesh> mesh(new Mesh());
+  DRACO_RETURN_IF_ERROR(DecodeMeshRealtime(in_buffer, mesh.get()));
+  return mesh;
+}
+
+}  // namespace draco
+
+#endif  // DRACO_COMPRESSION_MESH_MESH_REALTIME_CODING_H_
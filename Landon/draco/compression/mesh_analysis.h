@@ -0,0 +1,277 @@
+// Copyright 2020 The Draco Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DRACO_COMPRESSION_MESH_ANALYSIS_H_
+#define DRACO_COMPRESSION_MESH_ANALYSIS_H_
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "draco/compression/config/encoder_options.h"
+#include "draco/compression/expert_encode.h"
+#include "draco/core/encoder_buffer.h"
+#include "draco/core/parallel_for.h"
+#include "draco/core/quantization_utils.h"
+#include "draco/core/status.h"
+#include "draco/core/status_or.h"
+#include "draco/mesh/corner_table.h"
+#include "draco/mesh/mesh.h"
+#include "draco/mesh/mesh_attribute_corner_table.h"
+#include "draco/mesh/mesh_connectivity_cache.h"
+
+namespace draco {
+
+// Bounds of the values of a float attribute. |origin| and |range| are the
+// quantization parameters used for the attribute regardless of the number of
+// quantization bits (same as in AttributeQuantizationTransform).
+struct MeshAttributeBounds {
+  MeshAttributeBounds() : range(0.f) {}
+  std::vector<float> min_values;
+  std::vector<float> max_values;
+  std::vector<float> origin;
+  float range;
+};
+
+// Data derived from a mesh that is shared by any number of encodings of the
+// mesh with different options, e.g. a fast preview and an archival copy.
+// Create() computes the bounds of float attributes, which is all that
+// EncodeMeshWithAnalysis() needs. The position corner table with cached
+// valences and the corner tables of attributes with seams are only computed
+// on request by AnalyzeConnectivity(). All const methods only read data
+// computed by these two calls, so after the analysis is set up it can be used
+// from multiple threads concurrently. The mesh must not be modified while the
+// analysis is in use.
+class MeshAnalysis {
+ public:
+  // Computes the bounds of the float attributes of |mesh| in parallel on up
+  // to |num_threads| threads.
+  static StatusOr<std::unique_ptr<MeshAnalysis>> Create(const Mesh &mesh,
+                                                        int num_threads) {
+    std::unique_ptr<MeshAnalysis> analysis(new MeshAnalysis(mesh));
+    analysis->AnalyzeBounds(num_threads);
+    return analysis;
+  }
+
+  // Computes the corner table of the mesh, the valences of its vertices and
+  // the corner tables of attributes with seams. Attribute corner tables are
+  // computed in parallel on up to |num_threads| threads. Does nothing when
+  // the connectivity was already analyzed. Must not be called while the
+  // analysis is used by other threads.
+  Status AnalyzeConnectivity(int num_threads) {
+    if (corner_table_ != nullptr) {
+      return OkStatus();
+    }
+    const CornerTable *const corner_table =
+        connectivity_cache_.GetCornerTable(
+            MESH_CONNECTIVITY_POSITION_ATTRIBUTE);
+    if (corner_table == nullptr) {
+      return Status(Status::DRACO_ERROR, "Failed to build corner table.");
+    }
+    corner_table->GetValenceCache().CacheValences();
+
+    const int num_attributes = mesh_->num_attributes();
+    std::vector<std::unique_ptr<MeshAttributeCornerTable>> attribute_tables(
+        num_attributes);
+    std::vector<uint8_t> is_analyzed(num_attributes, 0);
+    ParallelFor(num_attributes,
+                GetNumParallelChunks(num_attributes, num_threads, 1),
+                [&](int /* chunk_id */, int64_t begin, int64_t end) {
+                  for (int64_t i = begin; i < end; ++i) {
+                    is_analyzed[i] = AnalyzeAttributeConnectivity(
+                        static_cast<int>(i), corner_table,
+                        &attribute_tables[i]);
+                  }
+                });
+    for (int i = 0; i < num_attributes; ++i) {
+      if (!is_analyzed[i]) {
+        return Status(Status::DRACO_ERROR, "Failed to analyze attribute.");
+      }
+    }
+    attribute_corner_tables_.swap(attribute_tables);
+    corner_table_ = corner_table;
+    return OkStatus();
+  }
+
+  const Mesh &mesh() const { return *mesh_; }
+
+  // Returns true when AnalyzeConnectivity() succeeded.
+  bool is_connectivity_analyzed() const { return corner_table_ != nullptr; }
+
+  // Corner table of the mesh built from the position attribute. Valences of
+  // all vertices are cached in its valence cache. Returns nullptr until
+  // AnalyzeConnectivity() is called.
+  const CornerTable *corner_table() const { return corner_table_; }
+
+  // Returns the corner table of attribute |att_id| that splits the mesh along
+  // the attribute seams, or nullptr when the attribute has no seams, when it
+  // is the position attribute or when AnalyzeConnectivity() was not called.
+  const MeshAttributeCornerTable *attribute_corner_table(int att_id) const {
+    if (corner_table_ == nullptr) {
+      return nullptr;
+    }
+    return attribute_corner_tables_[att_id].get();
+  }
+
+  // Returns the bounds of attribute |att_id|, or nullptr when the attribute
+  // does not store float values.
+  const MeshAttributeBounds *attribute_bounds(int att_id) const {
+    return attribute_bounds_[att_id].get();
+  }
+
+  // Returns the valence of the vertex |v| of corner_table(). Must not be
+  // called before AnalyzeConnectivity().
+  int valence(VertexIndex v) const {
+    return corner_table_->GetValenceCache().ConfidentValenceFromCache(v);
+  }
+
+ private:
+  explicit MeshAnalysis(const Mesh &mesh)
+      : mesh_(&mesh), connectivity_cache_(&mesh), corner_table_(nullptr) {}
+
+  void AnalyzeBounds(int num_threads) {
+    const int num_attributes = mesh_->num_attributes();
+    attribute_bounds_.resize(num_attributes);
+    ParallelFor(num_attributes,
+                GetNumParallelChunks(num_attributes, num_threads, 1),
+                [&](int /* chunk_id */, int64_t begin, int64_t end) {
+                  for (int64_t i = begin; i < end; ++i) {
+                    const PointAttribute *const att =
+                        mesh_->attribute(static_cast<int>(i));
+                    if (att->data_type() == DT_FLOAT32 && att->size() > 0) {
+                      attribute_bounds_[i] = ComputeBounds(*att);
+                    }
+                  }
+                });
+  }
+
+  // Computes the corner table of attribute |att_id| on top of the position
+  // |corner_table|. The table is stored in |out_table| only when the attribute
+  // has seams.
+  bool AnalyzeAttributeConnectivity(
+      int att_id, const CornerTable *corner_table,
+      std::unique_ptr<MeshAttributeCornerTable> *out_table) const {
+    const PointAttribute *const att = mesh_->attribute(att_id);
+    if (att->attribute_type() == GeometryAttribute::POSITION) {
+      return true;
+    }
+    std::unique_ptr<MeshAttributeCornerTable> table(
+        new MeshAttributeCornerTable());
+    if (!table->InitFromAttribute(mesh_, corner_table, att)) {
+      return false;
+    }
+    if (!table->no_interior_seams()) {
+      *out_table = std::move(table);
+    }
+    return true;
+  }
+
+  static std::unique_ptr<MeshAttributeBounds> ComputeBounds(
+      const PointAttribute &att) {
+    const int num_components = att.num_components();
+    const int num_entries = static_cast<int>(att.size());
+    // Gather the values when they are not stored contiguously.
+    const int64_t entry_size = sizeof(float) * num_components;
+    std::vector<float> gathered_values;
+    const float *values = nullptr;
+    if (att.byte_stride() == entry_size) {
+      values = reinterpret_cast<const float *>(
+          att.GetAddress(AttributeValueIndex(0)));
+    } else {
+      gathered_values.resize(num_entries * num_components);
+      for (int i = 0; i < num_entries; ++i) {
+        memcpy(&gathered_values[i * num_components],
+               att.GetAddress(AttributeValueIndex(i)), entry_size);
+      }
+      values = gathered_values.data();
+    }
+    std::unique_ptr<MeshAttributeBounds> bounds(new MeshAttributeBounds());
+    bounds->min_values.resize(num_components);
+    bounds->max_values.resize(num_components);
+    ComputeMinMaxValues(values, num_entries, num_components,
+                        bounds->min_values.data(), bounds->max_values.data());
+    bounds->origin = bounds->min_values;
+    for (int c = 0; c < num_components; ++c) {
+      bounds->range = std::max(bounds->range, bounds->max_values[c] -
+                                                  bounds->min_values[c]);
+    }
+    if (bounds->range == 0.f) {
+      bounds->range = 1.f;
+    }
+    return bounds;
+  }
+
+  const Mesh *mesh_;
+  // Owns the corner table computed by AnalyzeConnectivity().
+  MeshConnectivityCache connectivity_cache_;
+  const CornerTable *corner_table_;
+  std::vector<std::unique_ptr<MeshAttributeCornerTable>>
+      attribute_corner_tables_;
+  std::vector<std::unique_ptr<MeshAttributeBounds>> attribute_bounds_;
+};
+
+// Sets the quantization origin and range of all quantized float attributes in
+// |options| from the bounds in |analysis|, so that the encoder does not need to
+// scan the attribute values again. Only the bounds are applied; the encoder
+// computes its own connectivity. Attributes with an explicitly set
+// quantization origin or range are not modified.
+inline void ApplyMeshAnalysis(const MeshAnalysis &analysis,
+                              EncoderOptions *options) {
+  for (int i = 0; i < analysis.mesh().num_attributes(); ++i) {
+    const MeshAttributeBounds *const bounds = analysis.attribute_bounds(i);
+    if (bounds == nullptr ||
+        options->GetAttributeInt(i, "quantization_bits", -1) <= 0 ||
+        options->IsAttributeOptionSet(i, "quantization_origin") ||
+        options->IsAttributeOptionSet(i, "quantization_range")) {
+      continue;
+    }
+    options->SetAttributeVector(i, "quantization_origin",
+                                static_cast<int>(bounds->origin.size()),
+                                bounds->origin.data());
+    options->SetAttributeFloat(i, "quantization_range", bounds->range);
+  }
+}
+
+// Encodes the mesh of |analysis| once for each entry of |options| into the
+// matching entry of |out_buffers|. The encodings use ExpertEncoder with the
+// options updated by ApplyMeshAnalysis() and run in parallel on up to
+// |num_threads| threads.
+inline Status EncodeMeshWithAnalysis(
+    const MeshAnalysis &analysis, const std::vector<EncoderOptions> &options,
+    int num_threads, std::vector<EncoderBuffer> *out_buffers) {
+  const int num_encodings = static_cast<int>(options.size());
+  out_buffers->clear();
+  out_buffers->resize(num_encodings);
+  std::vector<Status> status(num_encodings);
+  ParallelFor(num_encodings,
+              GetNumParallelChunks(num_encodings, num_threads, 1),
+              [&](int /* chunk_id */, int64_t begin, int64_t end) {
+                for (int64_t i = begin; i < end; ++i) {
+                  EncoderOptions encoding_options = options[i];
+                  ApplyMeshAnalysis(analysis, &encoding_options);
+                  ExpertEncoder encoder(analysis.mesh());
+                  encoder.Reset(encoding_options);
+                  status[i] = encoder.EncodeToBuffer(&(*out_buffers)[i]);
+                }
+              });
+  for (int i = 0; i < num_encodings; ++i) {
+    DRACO_RETURN_IF_ERROR(status[i]);
+  }
+  return OkStatus();
+}
+
+}  // namespace draco
+
+#endif  // DRACO_COMPRESSION_MESH_ANALYSIS_H_
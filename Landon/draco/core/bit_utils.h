@@ -102,6 +102,37 @@ typename std::make_unsigned<IntTypeT>::type ConvertSignedIntToSymbol(
   return ret;
 }
 
+// Branch free version of ConvertSignedIntToSymbol() for 32-bit values.
+inline uint32_t ConvertSignedIntToSymbolBranchless(int32_t val) {
+  const uint32_t uval = static_cast<uint32_t>(val);
+  return (uval << 1) ^ (0u - (uval >> 31));
+}
+
+// Branch free version of ConvertSymbolToSignedInt() for 32-bit values.
+inline int32_t ConvertSymbolToSignedIntBranchless(uint32_t val) {
+  return static_cast<int32_t>((val >> 1) ^ (0u - (val & 1)));
+}
+
+// Same as ConvertSignedIntsToSymbols() but inlined and without data dependent
+// branches so that the compiler can vectorize the loop.
+inline void ConvertSignedIntsToSymbolsBranchless(const int32_t *in,
+                                                 int in_values,
+                                                 uint32_t *out) {
+  for (int i = 0; i < in_values; ++i) {
+    out[i] = ConvertSignedIntToSymbolBranchless(in[i]);
+  }
+}
+
+// Same as ConvertSymbolsToSignedInts() but inlined and without data dependent
+// branches so that the compiler can vectorize the loop.
+inline void ConvertSymbolsToSignedIntsBranchless(const uint32_t *in,
+                                                 int in_values,
+                                                 int32_t *out) {
+  for (int i = 0; i < in_values; ++i) {
+    out[i] = ConvertSymbolToSignedIntBranchless(in[i]);
+  }
+}
+
 // Converts a single unsigned integer symbol encoded with an entropy encoder
 // back to a signed value.
 template <class IntTypeT>
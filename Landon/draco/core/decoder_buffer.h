@@ -147,12 +147,7 @@ class DecoderBuffer {
     inline uint32_t EnsureBits(int k) {
       DRACO_DCHECK_LE(k, 24);
       DRACO_DCHECK_LE(static_cast<uint64_t>(k), AvailBits());
-
-      uint32_t buf = 0;
-      for (int i = 0; i < k; ++i) {
-        buf |= PeekBit(i) << i;
-      }
-      return buf;  // Okay to return extra bits
+      return PeekBits(k);  // Okay to return extra bits
     }
 
     inline void ConsumeBits(int k) { bit_offset_ += k; }
@@ -161,38 +156,42 @@ class DecoderBuffer {
     inline bool GetBits(int32_t nbits, uint32_t *x) {
       DRACO_DCHECK_GE(nbits, 0);
       DRACO_DCHECK_LE(nbits, 32);
-      uint32_t value = 0;
-      for (int32_t bit = 0; bit < nbits; ++bit) {
-        value |= GetBit() << bit;
+      *x = PeekBits(nbits);
+      // Reading past the end of the buffer returns zero bits without moving
+      // the offset beyond the end.
+      const size_t end_offset =
+          static_cast<size_t>(bit_buffer_end_ - bit_buffer_) * 8;
+      const size_t next_offset = bit_offset_ + nbits;
+      if (next_offset <= end_offset) {
+        bit_offset_ = next_offset;
+      } else if (bit_offset_ < end_offset) {
+        bit_offset_ = end_offset;
       }
-      *x = value;
       return true;
     }
 
    private:
     // TODO(fgalligan): Add support for error reporting on range check.
-    // Returns one bit from the bit buffer.
-    inline int GetBit() {
-      const size_t off = bit_offset_;
-      const size_t byte_offset = off >> 3;
-      const int bit_shift = static_cast<int>(off & 0x7);
-      if (bit_buffer_ + byte_offset < bit_buffer_end_) {
-        const int bit = (bit_buffer_[byte_offset] >> bit_shift) & 1;
-        bit_offset_ = off + 1;
-        return bit;
-      }
-      return 0;
-    }
-
-    inline int PeekBit(int offset) {
-      const size_t off = bit_offset_ + offset;
-      const size_t byte_offset = off >> 3;
-      const int bit_shift = static_cast<int>(off & 0x7);
-      if (bit_buffer_ + byte_offset < bit_buffer_end_) {
-        const int bit = (bit_buffer_[byte_offset] >> bit_shift) & 1;
-        return bit;
+    // Returns |nbits| bits starting at the current offset without consuming
+    // them. Bits past the end of the bit buffer are returned as zeros.
+    inline uint32_t PeekBits(int32_t nbits) const {
+      const size_t byte_offset = bit_offset_ >> 3;
+      const int bit_shift = static_cast<int>(bit_offset_ & 0x7);
+      const size_t buffer_size =
+          static_cast<size_t>(bit_buffer_end_ - bit_buffer_);
+      // At most 7 + 32 bits are needed, so a single 64-bit load is enough.
+      uint64_t cache = 0;
+      if (byte_offset + sizeof(cache) <= buffer_size) {
+        memcpy(&cache, bit_buffer_ + byte_offset, sizeof(cache));
+      } else {
+        // Zero padded load of the tail of the buffer.
+        for (size_t i = byte_offset; i < buffer_size; ++i) {
+          cache |= static_cast<uint64_t>(bit_buffer_[i])
+                   << ((i - byte_offset) * 8);
+        }
       }
-      return 0;
+      return static_cast<uint32_t>((cache >> bit_shift) &
+                                   ((static_cast<uint64_t>(1) << nbits) - 1));
     }
 
     const uint8_t *bit_buffer_;
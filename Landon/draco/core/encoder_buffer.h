@@ -90,9 +90,26 @@ class EncoderBuffer {
     void PutBits(uint32_t data, int32_t nbits) {
       DRACO_DCHECK_GE(nbits, 0);
       DRACO_DCHECK_LE(nbits, 32);
-      for (int32_t bit = 0; bit < nbits; ++bit) {
-        PutBit((data >> bit) & 1);
+      // The bits are written one byte at a time instead of one bit at a time.
+      // Only the bits covered by |nbits| are modified in each byte, so the
+      // output is identical to writing the bits individually.
+      uint64_t bits = data & ((static_cast<uint64_t>(1) << nbits) - 1);
+      uint64_t off = static_cast<uint64_t>(bit_offset_);
+      while (nbits > 0) {
+        const int bit_shift = static_cast<int>(off & 0x7);
+        const int num_byte_bits =
+            nbits < 8 - bit_shift ? nbits : 8 - bit_shift;
+        const uint8_t mask =
+            static_cast<uint8_t>(((1u << num_byte_bits) - 1) << bit_shift);
+        uint8_t *const byte = reinterpret_cast<uint8_t *>(bit_buffer_) +
+                              (off >> 3);
+        *byte = static_cast<uint8_t>((*byte & ~mask) |
+                                     ((bits << bit_shift) & mask));
+        bits >>= num_byte_bits;
+        off += num_byte_bits;
+        nbits -= num_byte_bits;
       }
+      bit_offset_ = static_cast<size_t>(off);
     }
 
     // Return number of bits encoded so far.
@@ -109,21 +126,6 @@ class EncoderBuffer {
     }
 
    private:
-    void PutBit(uint8_t value) {
-      const int byte_size = 8;
-      const uint64_t off = static_cast<uint64_t>(bit_offset_);
-      const uint64_t byte_offset = off / byte_size;
-      const int bit_shift = off % byte_size;
-
-      // TODO(fgalligan): Check performance if we add a branch and only do one
-      // memory write if bit_shift is 7. Also try using a temporary variable to
-      // hold the bits before writing to the buffer.
-
-      bit_buffer_[byte_offset] &= ~(1 << bit_shift);
-      bit_buffer_[byte_offset] |= value << bit_shift;
-      bit_offset_++;
-    }
-
     char *bit_buffer_;
     size_t bit_offset_;
   };
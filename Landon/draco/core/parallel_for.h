@@ -0,0 +1,74 @@
+// Copyright 2020 The Draco Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DRACO_CORE_PARALLEL_FOR_H_
+#define DRACO_CORE_PARALLEL_FOR_H_
+
+#include <stdint.h>
+
+#include <thread>
+#include <vector>
+
+namespace draco {
+
+// Returns the number of threads that can run concurrently on this machine.
+// Always returns at least 1.
+inline int GetNumHardwareThreads() {
+  const unsigned int num_threads = std::thread::hardware_concurrency();
+  return num_threads > 0 ? static_cast<int>(num_threads) : 1;
+}
+
+// Returns the number of chunks ParallelFor() splits |num_items| into when
+// |num_threads| are requested and each chunk should have at least
+// |min_items_per_chunk| items.
+inline int GetNumParallelChunks(int64_t num_items, int num_threads,
+                                int64_t min_items_per_chunk) {
+  if (min_items_per_chunk < 1) {
+    min_items_per_chunk = 1;
+  }
+  int64_t num_chunks = num_items / min_items_per_chunk;
+  if (num_chunks > num_threads) {
+    num_chunks = num_threads;
+  }
+  return num_chunks > 1 ? static_cast<int>(num_chunks) : 1;
+}
+
+// Splits the range [0, num_items) into |num_chunks| contiguous chunks of
+// (almost) equal size and calls |func(chunk_id, begin, end)| for each of them.
+// Each chunk is processed on its own thread, the last one on the calling
+// thread. The function returns after all chunks have been processed.
+// The chunk boundaries depend only on |num_items| and |num_chunks|, so callers
+// that combine per-chunk results in the chunk order get deterministic output.
+template <class FunctionT>
+void ParallelFor(int64_t num_items, int num_chunks, const FunctionT &func) {
+  if (num_chunks <= 1 || num_items <= 1) {
+    func(0, static_cast<int64_t>(0), num_items);
+    return;
+  }
+  std::vector<std::thread> threads;
+  threads.reserve(num_chunks - 1);
+  for (int c = 0; c < num_chunks - 1; ++c) {
+    const int64_t begin = num_items * c / num_chunks;
+    const int64_t end = num_items * (c + 1) / num_chunks;
+    threads.emplace_back([&func, c, begin, end]() { func(c, begin, end); });
+  }
+  func(num_chunks - 1, num_items * (num_chunks - 1) / num_chunks, num_items);
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace draco
+
+#endif  // DRACO_CORE_PARALLEL_FOR_H_
@@ -23,12 +23,58 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <cmath>
+#include <memory>
 
 #include "draco/core/macros.h"
 
 namespace draco {
 
+// Number of entries processed together by the batch functions below. The
+// per-component values are replicated over a whole block so that the blocks
+// can be processed as flat arrays regardless of the number of components.
+static constexpr int kQuantizationBatchSize = 64;
+
+// Computes the per-component minimum and maximum of |num_entries| entries
+// stored contiguously in |values| with |num_components| components each, in a
+// single pass over the data. |num_entries| must be at least 1. The result is
+// the same as when the entries are compared one by one, except that the sign
+// of a zero result may differ when both -0.f and +0.f are present. NaN values
+// are ignored unless they are stored in the first entry.
+inline void ComputeMinMaxValues(const float *values, int num_entries,
+                                int num_components, float *out_min_values,
+                                float *out_max_values) {
+  const int block_size = kQuantizationBatchSize * num_components;
+  std::unique_ptr<float[]> min_block(new float[block_size]);
+  std::unique_ptr<float[]> max_block(new float[block_size]);
+  for (int i = 0; i < block_size; ++i) {
+    min_block[i] = max_block[i] = values[i % num_components];
+  }
+  const int num_values = num_entries * num_components;
+  for (int first = 0; first < num_values; first += block_size) {
+    const int n = std::min(block_size, num_values - first);
+    const float *const block = values + first;
+    for (int i = 0; i < n; ++i) {
+      min_block[i] = min_block[i] > block[i] ? block[i] : min_block[i];
+      max_block[i] = max_block[i] < block[i] ? block[i] : max_block[i];
+    }
+  }
+  for (int c = 0; c < num_components; ++c) {
+    out_min_values[c] = min_block[c];
+    out_max_values[c] = max_block[c];
+  }
+  for (int i = num_components; i < block_size; ++i) {
+    const int c = i % num_components;
+    if (out_min_values[c] > min_block[i]) {
+      out_min_values[c] = min_block[i];
+    }
+    if (out_max_values[c] < max_block[i]) {
+      out_max_values[c] = max_block[i];
+    }
+  }
+}
+
 // Class for quantizing single precision floating point values. The values
 // should be centered around zero and be within interval (-range, +range), where
 // the range is specified in the Init() method. Alternatively, the quantization
@@ -50,6 +96,26 @@ class Quantizer {
   }
   inline int32_t operator()(float val) const { return QuantizeFloat(val); }
 
+  // Quantizes |num_entries| entries with |num_components| components each
+  // stored in |values|. The per-component |origin| is subtracted from the
+  // values before the quantization, using the same rounding as QuantizeFloat().
+  void QuantizeFloats(const float *values, int num_entries, int num_components,
+                      const float *origin, int32_t *out_values) const {
+    const int block_size = kQuantizationBatchSize * num_components;
+    std::unique_ptr<float[]> origin_block(new float[block_size]);
+    for (int i = 0; i < block_size; ++i) {
+      origin_block[i] = origin[i % num_components];
+    }
+    const int num_values = num_entries * num_components;
+    for (int first = 0; first < num_values; first += block_size) {
+      const int n = std::min(block_size, num_values - first);
+      for (int i = 0; i < n; ++i) {
+        out_values[first + i] =
+            QuantizeFloat(values[first + i] - origin_block[i]);
+      }
+    }
+  }
+
  private:
   float inverse_delta_;
 };
@@ -73,6 +139,27 @@ class Dequantizer {
   }
   inline float operator()(int32_t val) const { return DequantizeFloat(val); }
 
+  // Dequantizes |num_entries| entries with |num_components| components each
+  // stored in |values| and adds the per-component |origin| to the result.
+  // |out_values| can point directly to the buffer of the target attribute.
+  void DequantizeFloats(const int32_t *values, int num_entries,
+                        int num_components, const float *origin,
+                        float *out_values) const {
+    const int block_size = kQuantizationBatchSize * num_components;
+    std::unique_ptr<float[]> origin_block(new float[block_size]);
+    for (int i = 0; i < block_size; ++i) {
+      origin_block[i] = origin[i % num_components];
+    }
+    const int num_values = num_entries * num_components;
+    for (int first = 0; first < num_values; first += block_size) {
+      const int n = std::min(block_size, num_values - first);
+      for (int i = 0; i < n; ++i) {
+        out_values[first + i] =
+            DequantizeFloat(values[first + i]) + origin_block[i];
+      }
+    }
+  }
+
  private:
   float delta_;
 };
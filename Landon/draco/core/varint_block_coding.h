@@ -0,0 +1,338 @@
+// Copyright 2020 The Draco Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// File providing functions for coding runs of 32-bit integers with a
+// block-oriented variable length code (a.k.a. Stream VByte). Instead of
+// interleaving the continuation bits with the data like EncodeVarint() does,
+// the byte length of each value is stored as a 2-bit code in a separate stream
+// of control bytes. One control byte describes a group of four values, so the
+// decoder can compute the position of all four values up front and read them
+// without any data dependent branches.
+#ifndef DRACO_CORE_VARINT_BLOCK_CODING_H_
+#define DRACO_CORE_VARINT_BLOCK_CODING_H_
+
+#include <cstring>
+#include <vector>
+
+#include "draco/core/bit_utils.h"
+#include "draco/core/decoder_buffer.h"
+#include "draco/core/encoder_buffer.h"
+#include "draco/core/varint_decoding.h"
+#include "draco/core/varint_encoding.h"
+
+namespace draco {
+
+// Methods that can be used for coding runs of integers. The selected method is
+// stored in the bitstream in front of the encoded values.
+enum VarintCodingMethod {
+  // Each value is coded with EncodeVarint().
+  VARINT_CODING_SEQUENTIAL = 0,
+  // Values are coded in groups of four with a separate stream of control
+  // bytes.
+  VARINT_CODING_STREAM_VBYTE = 1,
+  NUM_VARINT_CODING_METHODS,
+};
+
+namespace {
+
+// Number of bytes used by a value described by a 2-bit |code|.
+inline int GetVarintBlockValueSize(uint32_t code) {
+  return static_cast<int>(code) + 1;
+}
+
+// Returns the 2-bit code describing the number of bytes needed by |val|.
+inline uint32_t GetVarintBlockCode(uint32_t val) {
+  return (val > 0xff) + (val > 0xffff) + (val > 0xffffff);
+}
+
+// Returns the number of data bytes used by all values of a group described by
+// a |control| byte.
+inline int GetVarintBlockGroupSize(uint32_t control) {
+  return 4 + static_cast<int>((control & 3) + ((control >> 2) & 3) +
+                              ((control >> 4) & 3) + (control >> 6));
+}
+
+// Reads a value described by a 2-bit |code| from |data|. Always loads four
+// bytes so at least four bytes must be readable from |data|.
+inline uint32_t LoadVarintBlockValue(const uint8_t *data, uint32_t code) {
+  // Masks of the bits used by values stored in 1, 2, 3 and 4 bytes.
+  static constexpr uint32_t kValueMasks[4] = {0xff, 0xffff, 0xffffff,
+                                              0xffffffff};
+  uint32_t val;
+  memcpy(&val, data, sizeof(val));
+  return val & kValueMasks[code];
+}
+
+// Reads a value described by a 2-bit |code| from |data| one byte at a time.
+// Only the bytes used by the value are accessed.
+inline uint32_t LoadVarintBlockValueSafe(const uint8_t *data, uint32_t code) {
+  uint32_t val = 0;
+  for (int i = GetVarintBlockValueSize(code) - 1; i >= 0; --i) {
+    val = (val << 8) | data[i];
+  }
+  return val;
+}
+
+// Returns the number of data bytes used by |num_values| values described by
+// the |control| bytes.
+inline int64_t GetVarintBlockDataSize(const uint8_t *control, int num_values) {
+  int64_t data_size = 0;
+  const int num_full_groups = num_values / 4;
+  for (int g = 0; g < num_full_groups; ++g) {
+    data_size += GetVarintBlockGroupSize(control[g]);
+  }
+  for (int i = num_full_groups * 4; i < num_values; ++i) {
+    const uint32_t code = (control[i >> 2] >> (2 * (i & 3))) & 3;
+    data_size += GetVarintBlockValueSize(code);
+  }
+  return data_size;
+}
+
+}  // namespace
+
+// Appends |num_values| values converted to unsigned integers by
+// |convert_value| to |out_buffer| using the Stream VByte layout. The values
+// are written directly into the storage of |out_buffer| that is first grown to
+// fit the largest possible output and then trimmed to the used size.
+template <typename ValueT, class ConvertFunctorT>
+inline bool EncodeVarintBlockValues(const ValueT *values, int num_values,
+                                    const ConvertFunctorT &convert_value,
+                                    EncoderBuffer *out_buffer) {
+  if (num_values < 0 || out_buffer->bit_encoder_active()) {
+    return false;
+  }
+  const int num_groups = (num_values + 3) / 4;
+  std::vector<char> *const buffer = out_buffer->buffer();
+  const size_t start = buffer->size();
+  // New elements are zero initialized, which the control byte of the last
+  // partial group relies on.
+  buffer->resize(start + num_groups + 4 * static_cast<size_t>(num_values));
+  uint8_t *const control = reinterpret_cast<uint8_t *>(buffer->data() + start);
+  uint8_t *data = control + num_groups;
+  // Full groups are written with four byte stores of whole values. The bytes
+  // past the end of a shorter value are overwritten by the next value.
+  const int num_full_groups = num_values / 4;
+  for (int g = 0; g < num_full_groups; ++g) {
+    const ValueT *const group = values + 4 * g;
+    uint32_t c = 0;
+    for (int j = 0; j < 4; ++j) {
+      const uint32_t val = convert_value(group[j]);
+      const uint32_t code = GetVarintBlockCode(val);
+      memcpy(data, &val, sizeof(uint32_t));
+      data += GetVarintBlockValueSize(code);
+      c |= code << (2 * j);
+    }
+    control[g] = static_cast<uint8_t>(c);
+  }
+  for (int i = num_full_groups * 4; i < num_values; ++i) {
+    const uint32_t val = convert_value(values[i]);
+    const uint32_t code = GetVarintBlockCode(val);
+    control[i >> 2] |= code << (2 * (i & 3));
+    for (int b = 0; b < 4; ++b) {
+      data[b] = static_cast<uint8_t>(val >> (8 * b));
+    }
+    data += GetVarintBlockValueSize(code);
+  }
+  buffer->resize(start + (data - control));
+  return true;
+}
+
+// Encodes |num_values| unsigned integers using the Stream VByte layout. All
+// control bytes are stored first, followed by the little endian data bytes of
+// all values. The number of values is not stored and it must be provided to
+// the decoder.
+inline bool EncodeVarintBlock(const uint32_t *values, int num_values,
+                              EncoderBuffer *out_buffer) {
+  return EncodeVarintBlockValues(
+      values, num_values, [](uint32_t val) { return val; }, out_buffer);
+}
+
+// Decodes |num_values| unsigned integers encoded by EncodeVarintBlock() into
+// |out_values|. Returns false on error.
+inline bool DecodeVarintBlock(int num_values, DecoderBuffer *in_buffer,
+                              uint32_t *out_values) {
+  if (num_values < 0) {
+    return false;
+  }
+  const int num_groups = (num_values + 3) / 4;
+  if (in_buffer->remaining_size() < num_groups) {
+    return false;
+  }
+  const uint8_t *const control =
+      reinterpret_cast<const uint8_t *>(in_buffer->data_head());
+  // Compute the size of the data first so that the full groups can be decoded
+  // without checking the buffer bounds.
+  const int64_t data_size = GetVarintBlockDataSize(control, num_values);
+  const int num_full_groups = num_values / 4;
+  if (in_buffer->remaining_size() - num_groups < data_size) {
+    return false;
+  }
+  const uint8_t *data = control + num_groups;
+  const uint8_t *const data_end = data + data_size;
+  int g = 0;
+  // Groups that have at least 16 readable bytes are decoded with four byte
+  // loads. Group positions depend only on the control bytes.
+  for (; g < num_full_groups && data_end - data >= 16; ++g) {
+    const uint32_t c = control[g];
+    const uint8_t *const d0 = data;
+    const uint8_t *const d1 = d0 + GetVarintBlockValueSize(c & 3);
+    const uint8_t *const d2 = d1 + GetVarintBlockValueSize((c >> 2) & 3);
+    const uint8_t *const d3 = d2 + GetVarintBlockValueSize((c >> 4) & 3);
+    uint32_t *const out = out_values + 4 * g;
+    out[0] = LoadVarintBlockValue(d0, c & 3);
+    out[1] = LoadVarintBlockValue(d1, (c >> 2) & 3);
+    out[2] = LoadVarintBlockValue(d2, (c >> 4) & 3);
+    out[3] = LoadVarintBlockValue(d3, c >> 6);
+    data = d3 + GetVarintBlockValueSize(c >> 6);
+  }
+  // Remaining values near the end of the data are read byte by byte.
+  for (int i = 4 * g; i < num_values; ++i) {
+    const uint32_t code = (control[i >> 2] >> (2 * (i & 3))) & 3;
+    out_values[i] = LoadVarintBlockValueSafe(data, code);
+    data += GetVarintBlockValueSize(code);
+  }
+  in_buffer->Advance(data_end - control);
+  return true;
+}
+
+// Encodes |num_values| unsigned integers with the given |method|. The method
+// is stored in front of the values so that DecodeVarints() can decode streams
+// produced by any of the methods.
+inline bool EncodeVarints(const uint32_t *values, int num_values,
+                          VarintCodingMethod method,
+                          EncoderBuffer *out_buffer) {
+  if (!out_buffer->Encode(static_cast<uint8_t>(method))) {
+    return false;
+  }
+  switch (method) {
+    case VARINT_CODING_SEQUENTIAL:
+      for (int i = 0; i < num_values; ++i) {
+        if (!EncodeVarint(values[i], out_buffer)) {
+          return false;
+        }
+      }
+      return true;
+    case VARINT_CODING_STREAM_VBYTE:
+      return EncodeVarintBlock(values, num_values, out_buffer);
+    default:
+      return false;
+  }
+}
+
+// Same as above but for signed integers. The values are converted to unsigned
+// symbols first (see ConvertSignedIntToSymbol()).
+inline bool EncodeVarints(const int32_t *values, int num_values,
+                          VarintCodingMethod method,
+                          EncoderBuffer *out_buffer) {
+  if (!out_buffer->Encode(static_cast<uint8_t>(method))) {
+    return false;
+  }
+  switch (method) {
+    case VARINT_CODING_SEQUENTIAL:
+      for (int i = 0; i < num_values; ++i) {
+        if (!EncodeVarint(ConvertSignedIntToSymbolBranchless(values[i]),
+                          out_buffer)) {
+          return false;
+        }
+      }
+      return true;
+    case VARINT_CODING_STREAM_VBYTE:
+      // The symbols are computed on the fly so that no temporary copy of the
+      // values is needed.
+      return EncodeVarintBlockValues(values, num_values,
+                                     ConvertSignedIntToSymbolBranchless,
+                                     out_buffer);
+    default:
+      return false;
+  }
+}
+
+// Decodes |num_values| unsigned integers encoded by EncodeVarints() into
+// |out_values|. Returns false on error.
+inline bool DecodeVarints(int num_values, DecoderBuffer *in_buffer,
+                          uint32_t *out_values) {
+  uint8_t method;
+  if (!in_buffer->Decode(&method)) {
+    return false;
+  }
+  switch (method) {
+    case VARINT_CODING_SEQUENTIAL:
+      for (int i = 0; i < num_values; ++i) {
+        if (!DecodeVarint(out_values + i, in_buffer)) {
+          return false;
+        }
+      }
+      return true;
+    case VARINT_CODING_STREAM_VBYTE:
+      return DecodeVarintBlock(num_values, in_buffer, out_values);
+    default:
+      return false;
+  }
+}
+
+// Same as above but for signed integers encoded by the signed version of
+// EncodeVarints().
+inline bool DecodeVarints(int num_values, DecoderBuffer *in_buffer,
+                          int32_t *out_values) {
+  uint32_t *const symbols = reinterpret_cast<uint32_t *>(out_values);
+  if (!DecodeVarints(num_values, in_buffer, symbols)) {
+    return false;
+  }
+  ConvertSymbolsToSignedIntsBranchless(symbols, num_values, out_values);
+  return true;
+}
+
+// Advances |in_buffer| past |num_values| integers encoded by EncodeVarints()
+// without decoding them. Returns false on error.
+inline bool SkipVarints(int num_values, DecoderBuffer *in_buffer) {
+  uint8_t method;
+  if (num_values < 0 || !in_buffer->Decode(&method)) {
+    return false;
+  }
+  const uint8_t *const data =
+      reinterpret_cast<const uint8_t *>(in_buffer->data_head());
+  const int64_t remaining_size = in_buffer->remaining_size();
+  int64_t size = 0;
+  switch (method) {
+    case VARINT_CODING_SEQUENTIAL:
+      // Each value ends with a byte that has the continuation bit cleared.
+      for (int i = 0; i < num_values; ++i) {
+        do {
+          if (size >= remaining_size) {
+            return false;
+          }
+        } while (data[size++] & 0x80);
+      }
+      break;
+    case VARINT_CODING_STREAM_VBYTE: {
+      const int num_groups = (num_values + 3) / 4;
+      if (remaining_size < num_groups) {
+        return false;
+      }
+      size = num_groups + GetVarintBlockDataSize(data, num_values);
+      if (size > remaining_size) {
+        return false;
+      }
+      break;
+    }
+    default:
+      return false;
+  }
+  in_buffer->Advance(size);
+  return true;
+}
+
+}  // namespace draco
+
+#endif  // DRACO_CORE_VARINT_BLOCK_CODING_H_
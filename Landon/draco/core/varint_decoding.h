@@ -24,34 +24,35 @@ namespace draco {
 
 namespace {
 
-// Decodes a specified unsigned integer as varint. |depth| is the current
-// recursion call depth. The first call to the function must be 1.
+// Decodes a specified unsigned integer as varint. |depth| is the number of
+// bytes of the value that were already decoded plus one. The first call to the
+// function must be 1.
 template <typename IntTypeT>
 bool DecodeVarintUnsigned(int depth, IntTypeT *out_val, DecoderBuffer *buffer) {
-  constexpr IntTypeT max_depth = sizeof(IntTypeT) + 1 + (sizeof(IntTypeT) >> 3);
-  if (depth > max_depth) {
-    return false;
-  }
+  constexpr int max_depth = sizeof(IntTypeT) + 1 + (sizeof(IntTypeT) >> 3);
   // Coding of unsigned values.
   // 0-6 bit - data
   // 7 bit - next byte?
-  uint8_t in;
-  if (!buffer->Decode(&in)) {
-    return false;
-  }
-  if (in & (1 << 7)) {
-    // Next byte is available, decode it first.
-    if (!DecodeVarintUnsigned<IntTypeT>(depth + 1, out_val, buffer)) {
-      return false;
+  // The bytes are read directly from the buffer and the value is accumulated
+  // starting from the least significant group of bits.
+  const uint8_t *const data =
+      reinterpret_cast<const uint8_t *>(buffer->data_head());
+  const int64_t remaining_size = buffer->remaining_size();
+  IntTypeT val = 0;
+  for (int i = 0; depth + i <= max_depth; ++i) {
+    if (i >= remaining_size) {
+      return false;  // Buffer overflow.
+    }
+    const uint8_t in = data[i];
+    val |= static_cast<IntTypeT>(in & ((1 << 7) - 1)) << (7 * i);
+    if (!(in & (1 << 7))) {
+      // Last byte reached
+      *out_val = val;
+      buffer->Advance(i + 1);
+      return true;
     }
-    // Append decoded info from this byte.
-    *out_val <<= 7;
-    *out_val |= in & ((1 << 7) - 1);
-  } else {
-    // Last byte reached
-    *out_val = in;
   }
-  return true;
+  return false;
 }
 
 }  // namespace
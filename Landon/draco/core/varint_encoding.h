@@ -30,19 +30,16 @@ bool EncodeVarint(IntTypeT val, EncoderBuffer *out_buffer) {
     // Coding of unsigned values.
     // 0-6 bit - data
     // 7 bit - next byte?
-    uint8_t out = 0;
-    out |= val & ((1 << 7) - 1);
-    if (val >= (1 << 7)) {
-      out |= (1 << 7);
-      if (!out_buffer->Encode(out)) {
-        return false;
-      }
-      if (!EncodeVarint<IntTypeT>(val >> 7, out_buffer)) {
-        return false;
-      }
-      return true;
+    // All bytes are gathered locally and written to the buffer at once.
+    uint8_t out[sizeof(IntTypeT) + 2];
+    int num_bytes = 0;
+    while (val >= (1 << 7)) {
+      out[num_bytes++] =
+          static_cast<uint8_t>((val & ((1 << 7) - 1)) | (1 << 7));
+      val >>= 7;
     }
-    if (!out_buffer->Encode(out)) {
+    out[num_bytes++] = static_cast<uint8_t>(val);
+    if (!out_buffer->Encode(out, num_bytes)) {
       return false;
     }
   } else {
@@ -0,0 +1,370 @@
+// Copyright 2020 The Draco Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DRACO_MESH_COMPACT_CORNER_TABLE_H_
+#define DRACO_MESH_COMPACT_CORNER_TABLE_H_
+
+#include <stdint.h>
+
+#include <limits>
+#include <vector>
+
+#include "draco/attributes/geometry_indices.h"
+#include "draco/core/macros.h"
+#include "draco/mesh/corner_table.h"
+#include "draco/mesh/corner_table_iterators.h"
+#include "draco/mesh/corner_table_parallel_construction.h"
+#include "draco/mesh/valence_cache.h"
+
+namespace draco {
+
+// Read-only copy of a CornerTable (or of any class with the same interface
+// such as MeshAttributeCornerTable) that stores all corner and vertex indices
+// using |IndexT|. The table can also be built directly from mesh faces, see
+// InitFromFaces(). With 16-bit indices the tables of small meshes take half the
+// memory of CornerTable, which keeps the whole connectivity in the cache during
+// traversal and prediction.
+//
+// Attribute seams of a MeshAttributeCornerTable are baked into the stored
+// opposite corners, so no per-corner seam flags need to be kept.
+//
+// The class implements the interface used by the mesh traversers (see
+// DepthFirstTraverser and MaxPredictionDegreeTraverser) and by the mesh
+// prediction schemes, so it can be used as their CornerTableT parameter.
+template <typename IndexT>
+class CompactCornerTable {
+ public:
+  typedef IndexT IndexType;
+  typedef CornerTable::FaceType FaceType;
+
+  CompactCornerTable() : valence_cache_(*this) {}
+
+  // Returns true when all indices of |table| can be stored using IndexT. The
+  // largest IndexT value is reserved for invalid indices.
+  template <class CornerTableT>
+  static bool CanRepresent(const CornerTableT &table) {
+    return static_cast<uint64_t>(table.num_corners()) < kInvalidIndex &&
+           static_cast<uint64_t>(table.num_vertices()) < kInvalidIndex;
+  }
+
+  // Copies the connectivity of |table|. Returns false when the indices of
+  // |table| do not fit into IndexT.
+  template <class CornerTableT>
+  bool InitFromCornerTable(const CornerTableT &table) {
+    if (!CanRepresent(table)) {
+      return false;
+    }
+    const int num_corners = table.num_corners();
+    const int num_vertices = table.num_vertices();
+    corner_to_vertex_map_.resize(num_corners);
+    opposite_corners_.resize(num_corners);
+    for (CornerIndex c(0); c < num_corners; ++c) {
+      corner_to_vertex_map_[c.value()] = ToIndex(table.Vertex(c));
+      opposite_corners_[c.value()] = ToIndex(table.Opposite(c));
+    }
+    vertex_corners_.resize(num_vertices);
+    vertex_parents_.resize(num_vertices);
+    for (VertexIndex v(0); v < num_vertices; ++v) {
+      vertex_corners_[v.value()] = ToIndex(table.LeftMostCorner(v));
+      const VertexIndex parent = table.VertexParent(v);
+      if (parent != kInvalidVertexIndex && parent.value() >= kInvalidIndex) {
+        return false;
+      }
+      vertex_parents_[v.value()] = ToIndex(parent);
+    }
+    return true;
+  }
+
+  // Copies the connectivity computed by
+  // ComputeCornerTableConnectivityParallel(). Returns false when the indices
+  // do not fit into IndexT.
+  bool InitFromConnectivity(const CornerTableConnectivity &connectivity) {
+    const int num_corners =
+        static_cast<int>(connectivity.corner_to_vertex_map.size());
+    const int num_vertices =
+        static_cast<int>(connectivity.vertex_corners.size());
+    if (static_cast<uint64_t>(num_corners) >= kInvalidIndex ||
+        static_cast<uint64_t>(num_vertices) >= kInvalidIndex) {
+      return false;
+    }
+    corner_to_vertex_map_.resize(num_corners);
+    opposite_corners_.resize(num_corners);
+    for (CornerIndex c(0); c < num_corners; ++c) {
+      corner_to_vertex_map_[c.value()] =
+          ToIndex(connectivity.corner_to_vertex_map[c]);
+      opposite_corners_[c.value()] = ToIndex(connectivity.opposite_corners[c]);
+    }
+    vertex_corners_.resize(num_vertices);
+    vertex_parents_.resize(num_vertices);
+    for (VertexIndex v(0); v < num_vertices; ++v) {
+      vertex_corners_[v.value()] = ToIndex(connectivity.vertex_corners[v]);
+      vertex_parents_[v.value()] =
+          v.value() < static_cast<uint32_t>(connectivity.num_original_vertices)
+              ? ToIndex(v)
+              : ToIndex(connectivity.non_manifold_vertex_parents[VertexIndex(
+                    v.value() - connectivity.num_original_vertices)]);
+    }
+    return true;
+  }
+
+  // Builds the table directly from |faces| with the same connectivity as
+  // CornerTable::Init(), without creating a CornerTable first. The opposite
+  // corners are computed on up to |num_threads| threads.
+  bool InitFromFaces(const IndexTypeVector<FaceIndex, FaceType> &faces,
+                     int num_threads) {
+    CornerTableConnectivity connectivity;
+    if (!ComputeCornerTableConnectivityParallel(faces, num_threads,
+                                                &connectivity)) {
+      return false;
+    }
+    return InitFromConnectivity(connectivity);
+  }
+
+  inline int num_vertices() const {
+    return static_cast<int>(vertex_corners_.size());
+  }
+  inline int num_corners() const {
+    return static_cast<int>(corner_to_vertex_map_.size());
+  }
+  inline int num_faces() const {
+    return static_cast<int>(corner_to_vertex_map_.size() / 3);
+  }
+
+  inline CornerIndex Opposite(CornerIndex corner) const {
+    if (corner == kInvalidCornerIndex) {
+      return corner;
+    }
+    return ToCornerIndex(opposite_corners_[corner.value()]);
+  }
+  inline CornerIndex Next(CornerIndex corner) const {
+    if (corner == kInvalidCornerIndex) {
+      return corner;
+    }
+    return LocalIndex(++corner) ? corner : corner - 3;
+  }
+  inline CornerIndex Previous(CornerIndex corner) const {
+    if (corner == kInvalidCornerIndex) {
+      return corner;
+    }
+    return LocalIndex(corner) ? corner - 1 : corner + 2;
+  }
+  inline VertexIndex Vertex(CornerIndex corner) const {
+    if (corner == kInvalidCornerIndex) {
+      return kInvalidVertexIndex;
+    }
+    return ConfidentVertex(corner);
+  }
+  inline VertexIndex ConfidentVertex(CornerIndex corner) const {
+    DRACO_DCHECK_LT(corner.value(), num_corners());
+    return ToVertexIndex(corner_to_vertex_map_[corner.value()]);
+  }
+  inline FaceIndex Face(CornerIndex corner) const {
+    if (corner == kInvalidCornerIndex) {
+      return kInvalidFaceIndex;
+    }
+    return FaceIndex(corner.value() / 3);
+  }
+  inline CornerIndex FirstCorner(FaceIndex face) const {
+    if (face == kInvalidFaceIndex) {
+      return kInvalidCornerIndex;
+    }
+    return CornerIndex(face.value() * 3);
+  }
+  inline std::array<CornerIndex, 3> AllCorners(FaceIndex face) const {
+    const CornerIndex ci = CornerIndex(face.value() * 3);
+    return {{ci, ci + 1, ci + 2}};
+  }
+  inline int LocalIndex(CornerIndex corner) const { return corner.value() % 3; }
+
+  inline FaceType FaceData(FaceIndex face) const {
+    const CornerIndex first_corner = FirstCorner(face);
+    FaceType face_data;
+    for (int i = 0; i < 3; ++i) {
+      face_data[i] = ConfidentVertex(first_corner + i);
+    }
+    return face_data;
+  }
+
+  inline CornerIndex LeftMostCorner(VertexIndex v) const {
+    return ToCornerIndex(vertex_corners_[v.value()]);
+  }
+
+  // Returns the parent vertex of a vertex of the source table (see
+  // CornerTable::VertexParent() and MeshAttributeCornerTable::VertexParent()).
+  inline VertexIndex VertexParent(VertexIndex vertex) const {
+    return ToVertexIndex(vertex_parents_[vertex.value()]);
+  }
+
+  inline bool IsValid(CornerIndex c) const {
+    return Vertex(c) != kInvalidVertexIndex;
+  }
+
+  bool IsDegenerated(FaceIndex face) const {
+    if (face == kInvalidFaceIndex) {
+      return true;
+    }
+    const CornerIndex first_face_corner = FirstCorner(face);
+    const VertexIndex v0 = Vertex(first_face_corner);
+    const VertexIndex v1 = Vertex(Next(first_face_corner));
+    const VertexIndex v2 = Vertex(Previous(first_face_corner));
+    return v0 == v1 || v0 == v2 || v1 == v2;
+  }
+
+  // Returns the valence (or degree) of a vertex.
+  // Returns -1 if the given vertex index is not valid.
+  int Valence(VertexIndex v) const {
+    if (v == kInvalidVertexIndex) {
+      return -1;
+    }
+    return ConfidentValence(v);
+  }
+  // Same as above but does not check for validity and does not return -1
+  int ConfidentValence(VertexIndex v) const {
+    DRACO_DCHECK_LT(v.value(), num_vertices());
+    VertexRingIterator<CompactCornerTable<IndexT>> vi(this, v);
+    int valence = 0;
+    for (; !vi.End(); vi.Next()) {
+      ++valence;
+    }
+    return valence;
+  }
+  inline int Valence(CornerIndex c) const {
+    if (c == kInvalidCornerIndex) {
+      return -1;
+    }
+    return ConfidentValence(c);
+  }
+  inline int ConfidentValence(CornerIndex c) const {
+    DRACO_DCHECK_LT(c.value(), num_corners());
+    return ConfidentValence(ConfidentVertex(c));
+  }
+
+  inline bool IsOnBoundary(VertexIndex vert) const {
+    const CornerIndex corner = LeftMostCorner(vert);
+    if (corner == kInvalidCornerIndex) {
+      return true;
+    }
+    if (SwingLeft(corner) == kInvalidCornerIndex) {
+      return true;
+    }
+    return false;
+  }
+
+  inline CornerIndex SwingRight(CornerIndex corner) const {
+    return Previous(Opposite(Previous(corner)));
+  }
+  inline CornerIndex SwingLeft(CornerIndex corner) const {
+    return Next(Opposite(Next(corner)));
+  }
+  inline CornerIndex GetLeftCorner(CornerIndex corner_id) const {
+    if (corner_id == kInvalidCornerIndex) {
+      return kInvalidCornerIndex;
+    }
+    return Opposite(Previous(corner_id));
+  }
+  inline CornerIndex GetRightCorner(CornerIndex corner_id) const {
+    if (corner_id == kInvalidCornerIndex) {
+      return kInvalidCornerIndex;
+    }
+    return Opposite(Next(corner_id));
+  }
+
+  const ValenceCache<CompactCornerTable<IndexT>> &GetValenceCache() const {
+    return valence_cache_;
+  }
+
+ private:
+  static constexpr uint64_t kInvalidIndex = std::numeric_limits<IndexT>::max();
+
+  template <class IndexTypeT>
+  static IndexT ToIndex(IndexTypeT index) {
+    return index.value() == std::numeric_limits<uint32_t>::max()
+               ? static_cast<IndexT>(kInvalidIndex)
+               : static_cast<IndexT>(index.value());
+  }
+  static CornerIndex ToCornerIndex(IndexT index) {
+    return index == kInvalidIndex ? kInvalidCornerIndex : CornerIndex(index);
+  }
+  static VertexIndex ToVertexIndex(IndexT index) {
+    return index == kInvalidIndex ? kInvalidVertexIndex : VertexIndex(index);
+  }
+
+  std::vector<IndexT> corner_to_vertex_map_;
+  std::vector<IndexT> opposite_corners_;
+  std::vector<IndexT> vertex_corners_;
+  std::vector<IndexT> vertex_parents_;
+
+  ValenceCache<CompactCornerTable<IndexT>> valence_cache_;
+};
+
+template <typename IndexT>
+constexpr uint64_t CompactCornerTable<IndexT>::kInvalidIndex;
+
+// Corner table with 16-bit indices for meshes with fewer than 65535 corners.
+typedef CompactCornerTable<uint16_t> CornerTable16;
+
+// Calls |func| with the most compact table that can represent the
+// connectivity of |table|: a CornerTable16 for small meshes and |table| itself
+// otherwise. The encoders and decoders of the prebuilt library instantiate
+// their traversers and prediction schemes with CornerTable and
+// MeshAttributeCornerTable, so the compact tables are only used by code that
+// runs its traversal through this function. |func| must accept both table
+// types, e.g. a generic lambda that instantiates a traverser for the table
+// type it receives:
+//
+//   VisitCompactCornerTable(*corner_table, [&](const auto &ct) {
+//     DepthFirstTraverser<std::decay_t<decltype(ct)>, Observer> traverser;
+//     ...
+//   });
+//
+// Returns the value returned by |func|.
+template <class CornerTableT, class FunctionT>
+bool VisitCompactCornerTable(const CornerTableT &table, FunctionT func) {
+  if (CornerTable16::CanRepresent(table)) {
+    CornerTable16 compact_table;
+    if (compact_table.InitFromCornerTable(table)) {
+      return func(static_cast<const CornerTable16 &>(compact_table));
+    }
+  }
+  return func(table);
+}
+
+// Same as above but the table is built directly from |faces| using up to
+// |num_threads| threads (see CompactCornerTable::InitFromFaces()). |func|
+// receives a CornerTable16 when the connectivity fits into 16-bit indices and
+// a CompactCornerTable<uint32_t> otherwise. Returns false when the table
+// could not be built.
+template <class FunctionT>
+bool VisitCompactCornerTable(
+    const IndexTypeVector<FaceIndex, CornerTable::FaceType> &faces,
+    int num_threads, FunctionT func) {
+  CornerTableConnectivity connectivity;
+  if (!ComputeCornerTableConnectivityParallel(faces, num_threads,
+                                              &connectivity)) {
+    return false;
+  }
+  CornerTable16 compact_table;
+  if (compact_table.InitFromConnectivity(connectivity)) {
+    return func(static_cast<const CornerTable16 &>(compact_table));
+  }
+  CompactCornerTable<uint32_t> table;
+  if (!table.InitFromConnectivity(connectivity)) {
+    return false;
+  }
+  return func(static_cast<const CompactCornerTable<uint32_t> &>(table));
+}
+
+}  // namespace draco
+
+#endif  // DRACO_MESH_COMPACT_CORNER_TABLE_H_
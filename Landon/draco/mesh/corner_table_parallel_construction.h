@@ -0,0 +1,509 @@
+// Copyright 2020 The Draco Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DRACO_MESH_CORNER_TABLE_PARALLEL_CONSTRUCTION_H_
+#define DRACO_MESH_CORNER_TABLE_PARALLEL_CONSTRUCTION_H_
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "draco/attributes/geometry_indices.h"
+#include "draco/core/draco_index_type_vector.h"
+#include "draco/core/parallel_for.h"
+#include "draco/mesh/corner_table.h"
+
+namespace draco {
+
+// Minimum number of corners processed by one thread when the opposite corners
+// are computed in parallel.
+static constexpr int64_t kMinCornersPerCornerTableThread = 1 << 16;
+
+// Number of high bits of the smaller edge vertex used to partition the
+// half-edges in the first radix sort pass.
+static constexpr int kHalfEdgePartitionBits = 11;
+
+// Edges with at most this many half-edges on a vertex are sorted with an
+// insertion sort.
+static constexpr int kMaxHalfEdgeInsertionSortSize = 16;
+
+// Computes opposite corners for the faces stored in |corner_to_vertex_map|
+// using up to |num_threads| threads. The output is identical to the output of
+// CornerTable::ComputeOppositeCorners(), which finds the opposite corners by
+// looking up the outgoing half-edges of each vertex one corner at a time.
+//
+// Here the half-edges of all non-degenerated faces are radix sorted by their
+// (min vertex, max vertex) key instead:
+//
+// 1. The first pass scatters the half-edges into partitions given by the high
+//    bits of the min vertex. Every thread counts its own range of faces and
+//    the ranges are scattered in order, so the result is stable and does not
+//    depend on the number of threads.
+// 2. The partitions cover disjoint vertex ranges and are processed in
+//    parallel. Each one is sorted by the remaining bits of the min vertex and
+//    then by the max vertex, which stably groups the half-edges of each edge
+//    in the corner order.
+// 3. Each group is matched in one sweep. A half-edge is connected to the
+//    first unmatched half-edge of the opposite orientation whose face is not a
+//    mirror of its own face. All remaining half-edges stay unconnected, which
+//    splits the non-manifold edges exactly like the serial algorithm does.
+//
+// |num_vertices| is set to the number of vertices referenced by the corners
+// and |num_degenerated_faces| to the number of skipped degenerated faces.
+inline bool ComputeOppositeCornersParallel(
+    const IndexTypeVector<CornerIndex, VertexIndex> &corner_to_vertex_map,
+    int num_threads,
+    IndexTypeVector<CornerIndex, CornerIndex> *opposite_corners,
+    int *num_vertices, int *num_degenerated_faces) {
+  if (num_vertices == nullptr || num_degenerated_faces == nullptr) {
+    return false;
+  }
+  const int64_t num_corners =
+      static_cast<int64_t>(corner_to_vertex_map.size());
+  const int64_t num_faces = num_corners / 3;
+  const VertexIndex *const vertices = corner_to_vertex_map.data();
+  opposite_corners->assign(num_corners, kInvalidCornerIndex);
+  *num_degenerated_faces = 0;
+  *num_vertices = 0;
+  if (num_faces == 0) {
+    return true;
+  }
+  const int num_chunks = GetNumParallelChunks(num_corners, num_threads,
+                                              kMinCornersPerCornerTableThread);
+
+  // Find the number of vertices.
+  std::vector<uint32_t> chunk_max_vertex(num_chunks, 0);
+  ParallelFor(num_corners, num_chunks,
+              [&](int chunk_id, int64_t begin, int64_t end) {
+                uint32_t max_vertex = 0;
+                for (int64_t c = begin; c < end; ++c) {
+                  max_vertex = std::max(max_vertex, vertices[c].value());
+                }
+                chunk_max_vertex[chunk_id] = max_vertex;
+              });
+  const uint32_t max_vertex =
+      *std::max_element(chunk_max_vertex.begin(), chunk_max_vertex.end());
+  *num_vertices = static_cast<int>(max_vertex) + 1;
+
+  int vertex_bits = 1;
+  while (vertex_bits < 32 && (max_vertex >> vertex_bits) != 0) {
+    ++vertex_bits;
+  }
+  const int partition_shift =
+      std::max(vertex_bits - kHalfEdgePartitionBits, 0);
+  const int num_partitions =
+      static_cast<int>(max_vertex >> partition_shift) + 1;
+
+  // Returns the source and sink vertices of the half-edge opposite to corner
+  // |c|.
+  const auto source_vertex = [vertices](uint32_t c) {
+    return vertices[c % 3 == 2 ? c - 2 : c + 1].value();
+  };
+  const auto sink_vertex = [vertices](uint32_t c) {
+    return vertices[c % 3 == 0 ? c + 2 : c - 1].value();
+  };
+  const auto is_degenerated = [vertices](int64_t f) {
+    const VertexIndex v0 = vertices[3 * f];
+    const VertexIndex v1 = vertices[3 * f + 1];
+    const VertexIndex v2 = vertices[3 * f + 2];
+    return v0 == v1 || v0 == v2 || v1 == v2;
+  };
+
+  // First radix sort pass: count the half-edges of every partition.
+  std::vector<int64_t> offsets(static_cast<size_t>(num_chunks) *
+                               num_partitions, 0);
+  std::vector<int> chunk_num_degenerated(num_chunks, 0);
+  ParallelFor(num_faces, num_chunks,
+              [&](int chunk_id, int64_t begin, int64_t end) {
+                int64_t *const counts =
+                    offsets.data() + chunk_id * num_partitions;
+                for (int64_t f = begin; f < end; ++f) {
+                  if (is_degenerated(f)) {
+                    ++chunk_num_degenerated[chunk_id];
+                    continue;
+                  }
+                  for (uint32_t c = 3 * f; c < 3 * f + 3; ++c) {
+                    const uint32_t min_v =
+                        std::min(source_vertex(c), sink_vertex(c));
+                    counts[min_v >> partition_shift]++;
+                  }
+                }
+              });
+  for (int c = 0; c < num_chunks; ++c) {
+    *num_degenerated_faces += chunk_num_degenerated[c];
+  }
+  // Convert the counts to offsets ordered by partition and then by chunk.
+  std::vector<int64_t> partition_offsets(num_partitions + 1);
+  int64_t offset = 0;
+  for (int p = 0; p < num_partitions; ++p) {
+    partition_offsets[p] = offset;
+    for (int c = 0; c < num_chunks; ++c) {
+      const int64_t count = offsets[c * num_partitions + p];
+      offsets[c * num_partitions + p] = offset;
+      offset += count;
+    }
+  }
+  partition_offsets[num_partitions] = offset;
+  std::vector<uint32_t> half_edges(offset);
+  ParallelFor(num_faces, num_chunks,
+              [&](int chunk_id, int64_t begin, int64_t end) {
+                int64_t *const chunk_offsets =
+                    offsets.data() + chunk_id * num_partitions;
+                for (int64_t f = begin; f < end; ++f) {
+                  if (is_degenerated(f)) {
+                    continue;
+                  }
+                  for (uint32_t c = 3 * f; c < 3 * f + 3; ++c) {
+                    const uint32_t min_v =
+                        std::min(source_vertex(c), sink_vertex(c));
+                    half_edges[chunk_offsets[min_v >> partition_shift]++] = c;
+                  }
+                }
+              });
+
+  // Second pass: sort each partition and match the half-edges.
+  const uint32_t vertex_mask = (1u << partition_shift) - 1;
+  ParallelFor(num_partitions, num_chunks, [&](int, int64_t begin,
+                                              int64_t end) {
+    std::vector<int64_t> vertex_offsets;
+    // Half-edges keyed by (max vertex, corner).
+    std::vector<uint64_t> sorted;
+    // Unmatched half-edges of the current edge for both orientations.
+    std::vector<uint32_t> unmatched[2];
+    for (int64_t p = begin; p < end; ++p) {
+      const uint32_t *const partition =
+          half_edges.data() + partition_offsets[p];
+      const int64_t partition_size =
+          partition_offsets[p + 1] - partition_offsets[p];
+      vertex_offsets.assign(vertex_mask + 2, 0);
+      for (int64_t i = 0; i < partition_size; ++i) {
+        const uint32_t c = partition[i];
+        const uint32_t min_v = std::min(source_vertex(c), sink_vertex(c));
+        vertex_offsets[(min_v & vertex_mask) + 1]++;
+      }
+      for (uint32_t v = 0; v <= vertex_mask; ++v) {
+        vertex_offsets[v + 1] += vertex_offsets[v];
+      }
+      sorted.resize(partition_size);
+      for (int64_t i = 0; i < partition_size; ++i) {
+        const uint32_t c = partition[i];
+        const uint32_t source_v = source_vertex(c);
+        const uint32_t sink_v = sink_vertex(c);
+        const uint32_t min_v = std::min(source_v, sink_v);
+        const uint64_t max_v = std::max(source_v, sink_v);
+        sorted[vertex_offsets[min_v & vertex_mask]++] = (max_v << 32) | c;
+      }
+      // |vertex_offsets| now point to the ends of the vertex ranges.
+      int64_t vertex_begin = 0;
+      for (uint32_t v = 0; v <= vertex_mask; ++v) {
+        const int64_t vertex_end = vertex_offsets[v];
+        if (vertex_end - vertex_begin <= kMaxHalfEdgeInsertionSortSize) {
+          for (int64_t i = vertex_begin + 1; i < vertex_end; ++i) {
+            const uint64_t key = sorted[i];
+            int64_t j = i;
+            for (; j > vertex_begin && sorted[j - 1] > key; --j) {
+              sorted[j] = sorted[j - 1];
+            }
+            sorted[j] = key;
+          }
+        } else {
+          std::sort(sorted.begin() + vertex_begin, sorted.begin() + vertex_end);
+        }
+        // Match the half-edges of every edge on the vertex.
+        int64_t i = vertex_begin;
+        while (i < vertex_end) {
+          int64_t edge_end = i + 1;
+          while (edge_end < vertex_end &&
+                 (sorted[edge_end] >> 32) == (sorted[i] >> 32)) {
+            ++edge_end;
+          }
+          if (edge_end - i == 2) {
+            // Common manifold case: the edge is shared by exactly two faces.
+            const uint32_t c0 = static_cast<uint32_t>(sorted[i]);
+            const uint32_t c1 = static_cast<uint32_t>(sorted[i + 1]);
+            if ((source_vertex(c0) < sink_vertex(c0)) !=
+                    (source_vertex(c1) < sink_vertex(c1)) &&
+                vertices[c0] != vertices[c1]) {
+              (*opposite_corners)[CornerIndex(c0)] = CornerIndex(c1);
+              (*opposite_corners)[CornerIndex(c1)] = CornerIndex(c0);
+            }
+            i = edge_end;
+            continue;
+          }
+          unmatched[0].clear();
+          unmatched[1].clear();
+          for (int64_t j = i; j < edge_end; ++j) {
+            const uint32_t c = static_cast<uint32_t>(sorted[j]);
+            const int forward = source_vertex(c) < sink_vertex(c) ? 1 : 0;
+            std::vector<uint32_t> &candidates = unmatched[1 - forward];
+            bool matched = false;
+            for (size_t k = 0; k < candidates.size(); ++k) {
+              const uint32_t opp = candidates[k];
+              if (vertices[opp] == vertices[c]) {
+                continue;  // Don't connect mirrored faces.
+              }
+              (*opposite_corners)[CornerIndex(c)] = CornerIndex(opp);
+              (*opposite_corners)[CornerIndex(opp)] = CornerIndex(c);
+              candidates.erase(candidates.begin() + k);
+              matched = true;
+              break;
+            }
+            if (!matched) {
+              unmatched[forward].push_back(c);
+            }
+          }
+          i = edge_end;
+        }
+        vertex_begin = vertex_end;
+      }
+    }
+  });
+  return true;
+}
+
+// Connectivity data of a corner table. The members have the same meaning as
+// the corresponding members of CornerTable.
+struct CornerTableConnectivity {
+  IndexTypeVector<CornerIndex, VertexIndex> corner_to_vertex_map;
+  IndexTypeVector<CornerIndex, CornerIndex> opposite_corners;
+  IndexTypeVector<VertexIndex, CornerIndex> vertex_corners;
+  // Parents of the vertices created for non-manifold vertices. The parent of
+  // vertex |num_original_vertices + i| is |non_manifold_vertex_parents[i]|.
+  IndexTypeVector<VertexIndex, VertexIndex> non_manifold_vertex_parents;
+  int num_original_vertices = 0;
+  int num_degenerated_faces = 0;
+  int num_isolated_vertices = 0;
+
+  CornerIndex Next(CornerIndex corner) const {
+    if (corner == kInvalidCornerIndex) {
+      return corner;
+    }
+    return corner.value() % 3 == 2 ? corner - 2 : corner + 1;
+  }
+  CornerIndex Previous(CornerIndex corner) const {
+    if (corner == kInvalidCornerIndex) {
+      return corner;
+    }
+    return corner.value() % 3 == 0 ? corner + 2 : corner - 1;
+  }
+  CornerIndex Opposite(CornerIndex corner) const {
+    if (corner == kInvalidCornerIndex) {
+      return corner;
+    }
+    return opposite_corners[corner];
+  }
+  CornerIndex SwingLeft(CornerIndex corner) const {
+    return Next(Opposite(Next(corner)));
+  }
+  CornerIndex SwingRight(CornerIndex corner) const {
+    return Previous(Opposite(Previous(corner)));
+  }
+};
+
+// Breaks the non-manifold edges caused by folds in the 1-ring neighborhood of
+// a vertex: when swinging around a vertex reaches an edge that was already
+// visited through a different face, the connectivity of both faces on that
+// edge is removed. This is the same procedure as the one used by
+// CornerTable::Init(), so the resulting opposite corners are identical.
+inline void BreakNonManifoldEdges(CornerTableConnectivity *connectivity) {
+  CornerTableConnectivity &ct = *connectivity;
+  const int num_corners = static_cast<int>(ct.corner_to_vertex_map.size());
+  std::vector<bool> visited_corners(num_corners, false);
+  std::vector<std::pair<VertexIndex, CornerIndex>> sink_vertices;
+  bool mesh_connectivity_updated = false;
+  do {
+    mesh_connectivity_updated = false;
+    for (CornerIndex c(0); c < num_corners; ++c) {
+      if (visited_corners[c.value()]) {
+        continue;
+      }
+      sink_vertices.clear();
+
+      // Swing all the way to the left to find the left-most corner of the
+      // corner's vertex.
+      CornerIndex first_c = c;
+      CornerIndex current_c = c;
+      CornerIndex next_c;
+      while (next_c = ct.SwingLeft(current_c),
+             next_c != first_c && next_c != kInvalidCornerIndex &&
+                 !visited_corners[next_c.value()]) {
+        current_c = next_c;
+      }
+      first_c = current_c;
+
+      // Swing right from the first corner and check that all visited edges
+      // are unique. Each edge is given by its sink vertex.
+      do {
+        visited_corners[current_c.value()] = true;
+        const CornerIndex sink_c = ct.Next(current_c);
+        const VertexIndex sink_v = ct.corner_to_vertex_map[sink_c];
+        // Corner that defines the edge on the face.
+        const CornerIndex edge_corner = ct.Previous(current_c);
+        bool vertex_connectivity_updated = false;
+        for (const auto &attached_sink_vertex : sink_vertices) {
+          if (attached_sink_vertex.first != sink_v) {
+            continue;
+          }
+          const CornerIndex other_edge_corner = attached_sink_vertex.second;
+          const CornerIndex opp_edge_corner = ct.Opposite(edge_corner);
+          if (opp_edge_corner == other_edge_corner) {
+            // We are closing the loop so no need to change the connectivity.
+            continue;
+          }
+          // Break the connectivity on the non-manifold edge.
+          const CornerIndex opp_other_edge_corner =
+              ct.Opposite(other_edge_corner);
+          if (opp_edge_corner != kInvalidCornerIndex) {
+            ct.opposite_corners[opp_edge_corner] = kInvalidCornerIndex;
+          }
+          if (opp_other_edge_corner != kInvalidCornerIndex) {
+            ct.opposite_corners[opp_other_edge_corner] = kInvalidCornerIndex;
+          }
+          ct.opposite_corners[edge_corner] = kInvalidCornerIndex;
+          ct.opposite_corners[other_edge_corner] = kInvalidCornerIndex;
+          vertex_connectivity_updated = true;
+          break;
+        }
+        if (vertex_connectivity_updated) {
+          // Not all corners of the vertex have been processed with the
+          // updated connectivity, so they need to be visited again.
+          mesh_connectivity_updated = true;
+          break;
+        }
+        sink_vertices.push_back(std::make_pair(
+            ct.corner_to_vertex_map[ct.Previous(current_c)], sink_c));
+        current_c = ct.SwingRight(current_c);
+      } while (current_c != first_c && current_c != kInvalidCornerIndex);
+    }
+  } while (mesh_connectivity_updated);
+}
+
+// Computes the left-most corner of every vertex. Vertices whose corners form
+// more than one fan are non-manifold and a new vertex is created for each
+// additional fan, in the same order as by CornerTable::Init().
+inline void ComputeVertexCorners(int num_vertices,
+                                 CornerTableConnectivity *connectivity) {
+  CornerTableConnectivity &ct = *connectivity;
+  const int num_corners = static_cast<int>(ct.corner_to_vertex_map.size());
+  ct.num_original_vertices = num_vertices;
+  ct.vertex_corners.assign(num_vertices, kInvalidCornerIndex);
+  ct.non_manifold_vertex_parents.clear();
+  std::vector<bool> visited_vertices(num_vertices, false);
+  std::vector<bool> visited_corners(num_corners, false);
+  for (CornerIndex first_face_corner(0); first_face_corner < num_corners;
+       first_face_corner += 3) {
+    const VertexIndex v0 = ct.corner_to_vertex_map[first_face_corner];
+    const VertexIndex v1 = ct.corner_to_vertex_map[first_face_corner + 1];
+    const VertexIndex v2 = ct.corner_to_vertex_map[first_face_corner + 2];
+    if (v0 == v1 || v0 == v2 || v1 == v2) {
+      continue;  // Degenerated faces are ignored.
+    }
+    for (int k = 0; k < 3; ++k) {
+      const CornerIndex c = first_face_corner + k;
+      if (visited_corners[c.value()]) {
+        continue;
+      }
+      VertexIndex v = ct.corner_to_vertex_map[c];
+      bool is_non_manifold_vertex = false;
+      if (visited_vertices[v.value()]) {
+        // A visited vertex of an unvisited corner must be non-manifold.
+        // Create a new vertex for it.
+        ct.vertex_corners.push_back(kInvalidCornerIndex);
+        ct.non_manifold_vertex_parents.push_back(v);
+        visited_vertices.push_back(false);
+        v = VertexIndex(num_vertices++);
+        is_non_manifold_vertex = true;
+      }
+      visited_vertices[v.value()] = true;
+
+      // Swing all the way to the left and mark all corners on the way.
+      CornerIndex act_c(c);
+      while (act_c != kInvalidCornerIndex) {
+        visited_corners[act_c.value()] = true;
+        // The vertex will eventually point to the left-most corner.
+        ct.vertex_corners[v] = act_c;
+        if (is_non_manifold_vertex) {
+          ct.corner_to_vertex_map[act_c] = v;
+        }
+        act_c = ct.SwingLeft(act_c);
+        if (act_c == c) {
+          break;  // Full circle reached.
+        }
+      }
+      if (act_c == kInvalidCornerIndex) {
+        // An open boundary was reached, so the corners on the other side of
+        // the initial corner need to be marked too.
+        act_c = ct.SwingRight(c);
+        while (act_c != kInvalidCornerIndex) {
+          visited_corners[act_c.value()] = true;
+          if (is_non_manifold_vertex) {
+            ct.corner_to_vertex_map[act_c] = v;
+          }
+          act_c = ct.SwingRight(act_c);
+        }
+      }
+    }
+  }
+  ct.num_isolated_vertices = 0;
+  for (size_t i = 0; i < visited_vertices.size(); ++i) {
+    if (!visited_vertices[i]) {
+      ++ct.num_isolated_vertices;
+    }
+  }
+}
+
+// Computes the same connectivity as CornerTable::Init() for |faces|. The
+// opposite corners are computed by ComputeOppositeCornersParallel() on up to
+// |num_threads| threads; the non-manifold edges and vertices are then
+// resolved serially in the same way as by CornerTable::Init().
+inline bool ComputeCornerTableConnectivityParallel(
+    const IndexTypeVector<FaceIndex, CornerTable::FaceType> &faces,
+    int num_threads, CornerTableConnectivity *connectivity) {
+  const size_t num_faces = faces.size();
+  if (num_faces > std::numeric_limits<uint32_t>::max() / 3) {
+    return false;
+  }
+  connectivity->corner_to_vertex_map.resize(3 * num_faces);
+  ParallelFor(static_cast<int64_t>(num_faces),
+              GetNumParallelChunks(static_cast<int64_t>(num_faces),
+                                   num_threads,
+                                   kMinCornersPerCornerTableThread / 3),
+              [&](int /* chunk_id */, int64_t begin, int64_t end) {
+                for (int64_t f = begin; f < end; ++f) {
+                  const CornerTable::FaceType &face =
+                      faces[FaceIndex(static_cast<uint32_t>(f))];
+                  for (int k = 0; k < 3; ++k) {
+                    connectivity->corner_to_vertex_map[CornerIndex(
+                        static_cast<uint32_t>(3 * f + k))] = face[k];
+                  }
+                }
+              });
+  int num_vertices = 0;
+  if (!ComputeOppositeCornersParallel(
+          connectivity->corner_to_vertex_map, num_threads,
+          &connectivity->opposite_corners, &num_vertices,
+          &connectivity->num_degenerated_faces)) {
+    return false;
+  }
+  BreakNonManifoldEdges(connectivity);
+  ComputeVertexCorners(num_vertices, connectivity);
+  return true;
+}
+
+}  // namespace draco
+
+#endif  // DRACO_MESH_CORNER_TABLE_PARALLEL_CONSTRUCTION_H_
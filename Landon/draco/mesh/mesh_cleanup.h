@@ -16,6 +16,7 @@
 #define DRACO_MESH_MESH_CLEANUP_H_
 
 #include "draco/mesh/mesh.h"
+#include "draco/mesh/mesh_connectivity_cache.h"
 
 namespace draco {
 
@@ -36,6 +37,17 @@ class MeshCleanup {
  public:
   // Performs in-place cleanup of the input mesh according to the input options.
   bool operator()(Mesh *mesh, const MeshCleanupOptions &options);
+
+  // Same as above but also invalidates the corner tables cached for |mesh|
+  // in |cache|, as the cleanup can edit the faces in place.
+  bool operator()(Mesh *mesh, const MeshCleanupOptions &options,
+                  MeshConnectivityCache *cache) {
+    const bool result = (*this)(mesh, options);
+    if (cache != nullptr) {
+      cache->Invalidate();
+    }
+    return result;
+  }
 };
 
 }  // namespace draco
@@ -0,0 +1,137 @@
+// Copyright 2020 The Draco Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DRACO_MESH_MESH_CONNECTIVITY_CACHE_H_
+#define DRACO_MESH_MESH_CONNECTIVITY_CACHE_H_
+
+#include <memory>
+#include <vector>
+
+#include "draco/mesh/corner_table.h"
+#include "draco/mesh/mesh.h"
+#include "draco/mesh/mesh_misc_functions.h"
+
+namespace draco {
+
+// Attributes that define the connectivity of a cached corner table.
+enum MeshConnectivitySource {
+  // Faces are connected when they share position values (see
+  // CreateCornerTableFromPositionAttribute()).
+  MESH_CONNECTIVITY_POSITION_ATTRIBUTE = 0,
+  // Faces are connected when they share values of all attributes (see
+  // CreateCornerTableFromAllAttributes()).
+  MESH_CONNECTIVITY_ALL_ATTRIBUTES,
+  NUM_MESH_CONNECTIVITY_SOURCES
+};
+
+// Lazily built corner tables of a single mesh, shared by all algorithms that
+// process the mesh in one pipeline (e.g. MeshStripifier, encoders, cleanup).
+// Each table is computed on its first request and reused afterwards as long as
+// the mesh does not change.
+//
+// The cache detects changes of the number of faces and points, reallocation of
+// the face storage and replacement or resizing of attributes. Faces or
+// attribute mappings that are edited in place are not detected and callers
+// that do so must call Invalidate().
+class MeshConnectivityCache {
+ public:
+  explicit MeshConnectivityCache(const Mesh *mesh) : mesh_(mesh) {}
+
+  // Returns the corner table of the mesh for the given connectivity |source|.
+  // The table is owned by the cache and stays valid until the cache is
+  // invalidated or destroyed. Returns nullptr on error.
+  const CornerTable *GetCornerTable(MeshConnectivitySource source) {
+    if (mesh_ == nullptr || source < 0 ||
+        source >= NUM_MESH_CONNECTIVITY_SOURCES) {
+      return nullptr;
+    }
+    MeshSignature signature;
+    ComputeSignature(&signature);
+    Entry &entry = entries_[source];
+    if (entry.corner_table != nullptr && entry.signature == signature) {
+      return entry.corner_table.get();
+    }
+    if (source == MESH_CONNECTIVITY_POSITION_ATTRIBUTE) {
+      entry.corner_table = CreateCornerTableFromPositionAttribute(mesh_);
+    } else {
+      entry.corner_table = CreateCornerTableFromAllAttributes(mesh_);
+    }
+    entry.signature = signature;
+    return entry.corner_table.get();
+  }
+
+  // Returns true when a valid corner table for |source| is cached.
+  bool IsCached(MeshConnectivitySource source) const {
+    if (source < 0 || source >= NUM_MESH_CONNECTIVITY_SOURCES ||
+        entries_[source].corner_table == nullptr) {
+      return false;
+    }
+    MeshSignature signature;
+    ComputeSignature(&signature);
+    return entries_[source].signature == signature;
+  }
+
+  // Releases all cached corner tables.
+  void Invalidate() {
+    for (int i = 0; i < NUM_MESH_CONNECTIVITY_SOURCES; ++i) {
+      entries_[i].corner_table.reset();
+    }
+  }
+
+  const Mesh *mesh() const { return mesh_; }
+
+ private:
+  // Cheap summary of the mesh state used to detect modifications of the mesh.
+  struct MeshSignature {
+    MeshSignature() : num_faces(0), num_points(0), faces(nullptr) {}
+    bool operator==(const MeshSignature &other) const {
+      return num_faces == other.num_faces && num_points == other.num_points &&
+             faces == other.faces && attributes == other.attributes &&
+             attribute_sizes == other.attribute_sizes;
+    }
+
+    uint32_t num_faces;
+    uint32_t num_points;
+    const Mesh::Face *faces;
+    std::vector<const PointAttribute *> attributes;
+    std::vector<size_t> attribute_sizes;
+  };
+
+  struct Entry {
+    std::unique_ptr<CornerTable> corner_table;
+    MeshSignature signature;
+  };
+
+  void ComputeSignature(MeshSignature *signature) const {
+    signature->num_faces = mesh_->num_faces();
+    signature->num_points = mesh_->num_points();
+    signature->faces =
+        mesh_->num_faces() > 0 ? &mesh_->face(FaceIndex(0)) : nullptr;
+    const int num_attributes = mesh_->num_attributes();
+    signature->attributes.resize(num_attributes);
+    signature->attribute_sizes.resize(num_attributes);
+    for (int i = 0; i < num_attributes; ++i) {
+      const PointAttribute *const att = mesh_->attribute(i);
+      signature->attributes[i] = att;
+      signature->attribute_sizes[i] = att == nullptr ? 0 : att->size();
+    }
+  }
+
+  const Mesh *mesh_;
+  Entry entries_[NUM_MESH_CONNECTIVITY_SOURCES];
+};
+
+}  // namespace draco
+
+#endif  // DRACO_MESH_MESH_CONNECTIVITY_CACHE_H_
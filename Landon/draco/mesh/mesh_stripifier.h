@@ -15,6 +15,7 @@
 #ifndef DRACO_SRC_DRACO_MESH_MESH_STRIPIFIER_H_
 #define DRACO_SRC_DRACO_MESH_MESH_STRIPIFIER_H_
 
+#include "draco/mesh/mesh_connectivity_cache.h"
 #include "draco/mesh/mesh_misc_functions.h"
 
 namespace draco {
@@ -34,9 +35,18 @@ class MeshStripifier {
  public:
   MeshStripifier()
       : mesh_(nullptr),
+        corner_table_(nullptr),
         num_strips_(0),
         num_encoded_faces_(0),
-        last_encoded_point_(kInvalidPointIndex) {}
+        last_encoded_point_(kInvalidPointIndex),
+        connectivity_cache_(nullptr) {}
+
+  // Sets a cache that provides the corner table of the processed mesh. When
+  // the cache belongs to the mesh passed to GenerateTriangleStrips*(), its
+  // position corner table is used instead of computing a new one.
+  void SetConnectivityCache(MeshConnectivityCache *cache) {
+    connectivity_cache_ = cache;
+  }
 
   // Generate triangle strips for a given mesh and output them to the output
   // iterator |out_it|. In most cases |out_it| stores the values in a buffer
@@ -71,9 +81,15 @@ class MeshStripifier {
     mesh_ = &mesh;
     num_strips_ = 0;
     num_encoded_faces_ = 0;
-    // TODO(ostava): We may be able to avoid computing the corner table if we
-    // already have it stored somewhere.
-    corner_table_ = CreateCornerTableFromPositionAttribute(mesh_);
+    owned_corner_table_.reset();
+    if (connectivity_cache_ != nullptr &&
+        connectivity_cache_->mesh() == mesh_) {
+      corner_table_ = connectivity_cache_->GetCornerTable(
+          MESH_CONNECTIVITY_POSITION_ATTRIBUTE);
+    } else {
+      owned_corner_table_ = CreateCornerTableFromPositionAttribute(mesh_);
+      corner_table_ = owned_corner_table_.get();
+    }
     if (corner_table_ == nullptr) {
       return false;
     }
@@ -164,7 +180,9 @@ class MeshStripifier {
   void GenerateStripsFromCorner(int local_strip_id, CornerIndex ci);
 
   const Mesh *mesh_;
-  std::unique_ptr<CornerTable> corner_table_;
+  // Corner table of |mesh_|. It is owned either by |owned_corner_table_| or by
+  // |connectivity_cache_|.
+  const CornerTable *corner_table_;
 
   // Store strip faces for each of three possible directions from a given face.
   std::vector<FaceIndex> strip_faces_[3];
@@ -177,6 +195,9 @@ class MeshStripifier {
   int num_encoded_faces_;
   // Last encoded point.
   PointIndex last_encoded_point_;
+  MeshConnectivityCache *connectivity_cache_;
+  // Corner table computed by Prepare() when no cache provides it.
+  std::unique_ptr<CornerTable> owned_corner_table_;
 };
 
 template <typename OutputIteratorT, typename IndexTypeT>
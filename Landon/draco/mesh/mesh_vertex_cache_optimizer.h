@@ -0,0 +1,326 @@
+// Copyright 2020 The Draco Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DRACO_MESH_MESH_VERTEX_CACHE_OPTIMIZER_H_
+#define DRACO_MESH_MESH_VERTEX_CACHE_OPTIMIZER_H_
+
+#include <stdint.h>
+
+#include <cstring>
+#include <vector>
+
+#include "draco/compression/config/decoder_options.h"
+#include "draco/mesh/mesh.h"
+
+namespace draco {
+
+// Size of the simulated post-transform vertex cache. Most GPUs behave like a
+// FIFO cache with 16 to 32 entries.
+static constexpr int kDefaultVertexCacheSize = 16;
+
+// Computes the number of vertex cache misses when the triangles given by
+// |indices| (three vertex indices per triangle) are processed by a FIFO cache
+// of |cache_size| entries. |num_vertices| must be larger than all indices.
+inline int64_t ComputeVertexCacheMisses(const std::vector<uint32_t> &indices,
+                                        uint32_t num_vertices,
+                                        int cache_size) {
+  // A vertex is in the cache when it was loaded less than |cache_size| misses
+  // ago.
+  std::vector<int64_t> load_times(num_vertices, -1);
+  int64_t num_misses = 0;
+  for (size_t i = 0; i < indices.size(); ++i) {
+    const uint32_t v = indices[i];
+    if (load_times[v] < 0 || num_misses - load_times[v] >= cache_size) {
+      load_times[v] = num_misses++;
+    }
+  }
+  return num_misses;
+}
+
+// Computes a triangle order of |indices| that is friendly to a post-transform
+// vertex cache of |cache_size| entries using the Tipsify algorithm (Sander et
+// al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw",
+// 2007). The algorithm fans around one vertex at a time and picks the next
+// fanning vertex among the vertices of the emitted triangles that are still in
+// the cache, falling back to a dead-end stack and to a linear scan. It runs in
+// time linear in the number of triangles. Stores the new order of the
+// original triangles in |face_order|.
+inline void ComputeVertexCacheOptimizedFaceOrder(
+    const std::vector<uint32_t> &indices, uint32_t num_vertices,
+    int cache_size, std::vector<uint32_t> *face_order) {
+  const uint32_t num_faces = static_cast<uint32_t>(indices.size() / 3);
+  face_order->clear();
+  face_order->reserve(num_faces);
+  if (num_faces == 0) {
+    return;
+  }
+  // Vertex-triangle adjacency stored in a compressed row format.
+  std::vector<uint32_t> adjacency_offsets(num_vertices + 1, 0);
+  for (size_t i = 0; i < 3 * static_cast<size_t>(num_faces); ++i) {
+    adjacency_offsets[indices[i] + 1]++;
+  }
+  for (uint32_t v = 0; v < num_vertices; ++v) {
+    adjacency_offsets[v + 1] += adjacency_offsets[v];
+  }
+  std::vector<uint32_t> adjacency(adjacency_offsets[num_vertices]);
+  {
+    std::vector<uint32_t> fill(adjacency_offsets.begin(),
+                               adjacency_offsets.end() - 1);
+    for (uint32_t f = 0; f < num_faces; ++f) {
+      for (int c = 0; c < 3; ++c) {
+        adjacency[fill[indices[3 * f + c]]++] = f;
+      }
+    }
+  }
+  // Number of not yet emitted triangles of each vertex.
+  std::vector<int> live_triangles(num_vertices);
+  for (uint32_t v = 0; v < num_vertices; ++v) {
+    live_triangles[v] = adjacency_offsets[v + 1] - adjacency_offsets[v];
+  }
+  std::vector<int64_t> cache_times(num_vertices, 0);
+  std::vector<bool> is_face_emitted(num_faces, false);
+  std::vector<uint32_t> dead_end_stack;
+  std::vector<uint32_t> candidates;
+  int64_t time = cache_size + 1;
+  uint32_t scan_cursor = 0;
+
+  int64_t fanning_vertex = indices[0];
+  while (fanning_vertex >= 0) {
+    candidates.clear();
+    const uint32_t fv = static_cast<uint32_t>(fanning_vertex);
+    for (uint32_t i = adjacency_offsets[fv]; i < adjacency_offsets[fv + 1];
+         ++i) {
+      const uint32_t f = adjacency[i];
+      if (is_face_emitted[f]) {
+        continue;
+      }
+      is_face_emitted[f] = true;
+      face_order->push_back(f);
+      for (int c = 0; c < 3; ++c) {
+        const uint32_t v = indices[3 * f + c];
+        dead_end_stack.push_back(v);
+        candidates.push_back(v);
+        live_triangles[v]--;
+        if (time - cache_times[v] > cache_size) {
+          cache_times[v] = time++;
+        }
+      }
+    }
+    // Pick the candidate that stays longest in the cache after all of its
+    // remaining triangles are emitted.
+    fanning_vertex = -1;
+    int64_t best_priority = -1;
+    for (uint32_t v : candidates) {
+      if (live_triangles[v] <= 0) {
+        continue;
+      }
+      int64_t priority = 0;
+      if (time - cache_times[v] + 2 * live_triangles[v] <= cache_size) {
+        priority = time - cache_times[v];
+      }
+      if (priority > best_priority) {
+        best_priority = priority;
+        fanning_vertex = v;
+      }
+    }
+    if (fanning_vertex >= 0) {
+      continue;
+    }
+    // Dead end: use the most recently referenced vertex that still has live
+    // triangles, or the next one in the input order.
+    while (!dead_end_stack.empty()) {
+      const uint32_t v = dead_end_stack.back();
+      dead_end_stack.pop_back();
+      if (live_triangles[v] > 0) {
+        fanning_vertex = v;
+        break;
+      }
+    }
+    while (fanning_vertex < 0 && scan_cursor < num_vertices) {
+      if (live_triangles[scan_cursor] > 0) {
+        fanning_vertex = scan_cursor;
+      }
+      ++scan_cursor;
+    }
+  }
+}
+
+// Statistics of the vertex cache efficiency of a mesh.
+struct MeshVertexCacheStats {
+  MeshVertexCacheStats() : acmr(0.f), atvr(0.f) {}
+  // Average cache miss ratio: vertex cache misses per triangle. The lower
+  // bound is 0.5 for large regular meshes and the upper bound is 3.
+  float acmr;
+  // Average transform to vertex ratio: vertex cache misses per referenced
+  // vertex. The optimum is 1.
+  float atvr;
+};
+
+// Reorders faces and points of a mesh for the GPU post-transform vertex cache
+// and for vertex fetch locality. Faces are ordered with
+// ComputeVertexCacheOptimizedFaceOrder() and points are then renumbered in the
+// order of their first use, so the vertex buffer is read almost sequentially.
+// Unreferenced points are moved to the end.
+class MeshVertexCacheOptimizer {
+ public:
+  MeshVertexCacheOptimizer() : cache_size_(kDefaultVertexCacheSize) {}
+
+  void set_cache_size(int cache_size) { cache_size_ = cache_size; }
+  int cache_size() const { return cache_size_; }
+
+  // Computes the cache statistics of |mesh| for the current cache size.
+  MeshVertexCacheStats ComputeStats(const Mesh &mesh) const {
+    std::vector<uint32_t> indices;
+    GetIndices(mesh, &indices);
+    MeshVertexCacheStats stats;
+    if (indices.empty()) {
+      return stats;
+    }
+    const int64_t num_misses =
+        ComputeVertexCacheMisses(indices, mesh.num_points(), cache_size_);
+    std::vector<bool> is_referenced(mesh.num_points(), false);
+    int64_t num_referenced = 0;
+    for (uint32_t v : indices) {
+      if (!is_referenced[v]) {
+        is_referenced[v] = true;
+        ++num_referenced;
+      }
+    }
+    stats.acmr = static_cast<float>(num_misses) / mesh.num_faces();
+    stats.atvr = static_cast<float>(num_misses) / num_referenced;
+    return stats;
+  }
+
+  // Optimizes |mesh| in place. When |stats_before| or |stats_after| are not
+  // null, they are filled with the cache statistics of the input and output.
+  bool Optimize(Mesh *mesh, MeshVertexCacheStats *stats_before,
+                MeshVertexCacheStats *stats_after) const {
+    if (stats_before != nullptr) {
+      *stats_before = ComputeStats(*mesh);
+    }
+    std::vector<uint32_t> indices;
+    GetIndices(*mesh, &indices);
+    const uint32_t num_points = mesh->num_points();
+    std::vector<uint32_t> face_order;
+    ComputeVertexCacheOptimizedFaceOrder(indices, num_points, cache_size_,
+                                         &face_order);
+
+    // Renumber the points in the order of their first use.
+    std::vector<PointIndex> new_point_ids(num_points, kInvalidPointIndex);
+    std::vector<PointIndex> old_point_ids;
+    old_point_ids.reserve(num_points);
+    for (uint32_t f : face_order) {
+      for (int c = 0; c < 3; ++c) {
+        const uint32_t p = indices[3 * f + c];
+        if (new_point_ids[p] == kInvalidPointIndex) {
+          new_point_ids[p] =
+              PointIndex(static_cast<uint32_t>(old_point_ids.size()));
+          old_point_ids.push_back(PointIndex(p));
+        }
+      }
+    }
+    for (uint32_t p = 0; p < num_points; ++p) {
+      if (new_point_ids[p] == kInvalidPointIndex) {
+        new_point_ids[p] =
+            PointIndex(static_cast<uint32_t>(old_point_ids.size()));
+        old_point_ids.push_back(PointIndex(p));
+      }
+    }
+
+    for (uint32_t i = 0; i < face_order.size(); ++i) {
+      const uint32_t f = face_order[i];
+      mesh->SetFace(FaceIndex(i),
+                    {{new_point_ids[indices[3 * f]],
+                      new_point_ids[indices[3 * f + 1]],
+                      new_point_ids[indices[3 * f + 2]]}});
+    }
+    for (int att_id = 0; att_id < mesh->num_attributes(); ++att_id) {
+      PermuteAttributePoints(old_point_ids, mesh->attribute(att_id));
+    }
+    if (stats_after != nullptr) {
+      *stats_after = ComputeStats(*mesh);
+    }
+    return true;
+  }
+
+ private:
+  static void GetIndices(const Mesh &mesh, std::vector<uint32_t> *indices) {
+    indices->resize(3 * static_cast<size_t>(mesh.num_faces()));
+    for (FaceIndex f(0); f < mesh.num_faces(); ++f) {
+      const Mesh::Face &face = mesh.face(f);
+      for (int c = 0; c < 3; ++c) {
+        (*indices)[3 * f.value() + c] = face[c].value();
+      }
+    }
+  }
+
+  // Moves the attribute entry of point |old_point_ids[p]| to point |p|.
+  static void PermuteAttributePoints(
+      const std::vector<PointIndex> &old_point_ids, PointAttribute *att) {
+    const uint32_t num_points = static_cast<uint32_t>(old_point_ids.size());
+    if (att->is_mapping_identity()) {
+      // Point ids are attribute value ids, so the values need to be moved.
+      const int64_t stride = att->byte_stride();
+      std::vector<uint8_t> values(att->size() * stride);
+      if (values.empty()) {
+        return;
+      }
+      memcpy(values.data(), att->GetAddress(AttributeValueIndex(0)),
+             values.size());
+      for (uint32_t p = 0; p < num_points && p < att->size(); ++p) {
+        if (old_point_ids[p].value() < att->size()) {
+          att->SetAttributeValue(AttributeValueIndex(p),
+                                 &values[old_point_ids[p].value() * stride]);
+        }
+      }
+      return;
+    }
+    std::vector<AttributeValueIndex> old_map(num_points);
+    for (uint32_t p = 0; p < num_points; ++p) {
+      old_map[p] = att->mapped_index(PointIndex(p));
+    }
+    for (uint32_t p = 0; p < num_points; ++p) {
+      att->SetPointMapEntry(PointIndex(p), old_map[old_point_ids[p].value()]);
+    }
+  }
+
+  int cache_size_;
+};
+
+// Decoder options that control the optimizations applied by
+// OptimizeDecodedMesh():
+//
+//   "optimize_vertex_cache" (bool, default false): Reorders the faces and
+//       points of the decoded mesh with MeshVertexCacheOptimizer.
+//   "vertex_cache_size" (int, default kDefaultVertexCacheSize): Simulated
+//       vertex cache size.
+//
+// Applies the optimizations requested by |options| to a decoded |mesh|. When
+// |stats_before| or |stats_after| are not null, they receive the vertex cache
+// statistics of the mesh before and after the optimization.
+inline bool OptimizeDecodedMesh(const DecoderOptions &options, Mesh *mesh,
+                                MeshVertexCacheStats *stats_before,
+                                MeshVertexCacheStats *stats_after) {
+  if (!options.GetGlobalBool("optimize_vertex_cache", false)) {
+    return true;
+  }
+  MeshVertexCacheOptimizer optimizer;
+  optimizer.set_cache_size(
+      options.GetGlobalInt("vertex_cache_size", kDefaultVertexCacheSize));
+  return optimizer.Optimize(mesh, stats_before, stats_after);
+}
+
+}  // namespace draco
+
+#endif  // DRACO_MESH_MESH_VERTEX_CACHE_OPTIMIZER_H_